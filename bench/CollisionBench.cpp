@@ -0,0 +1,487 @@
+// Headless collision benchmark: octree, loose octree and BVH on a level mesh,
+// the loose octree with quantized triangles ("quant"), plus the two-level
+// scene (one shared loose octree, an instance per tile), queried directly and
+// through a player contact cache ("cached").
+// Usage: collision-bench [path/to/level.gltf] [path/to/trace]
+// Run from the build directory, like ogl-test (default asset path is relative).
+// The trace is one recorded by ogl-test with Config::COLLISION_TRACE_PATH set.
+//
+// Workloads, all through the calls runEngine makes:
+//   scatter  sphere contacts around random surface points (plus the batch path)
+//   walk     synthetic players walking the level: the player collision of
+//            stepSimulation (stepPlayerCollision: contact, then the filtered
+//            fall sweep) and a camera boom sweep per tick
+//   trace    the recorded player trace, if given
+//   move     (scene only) every tile moved up and down once per walk tick
+// Latency percentiles time each query on its own, so they include ~20-40 ns
+// of clock overhead that ns/query (one timed loop) does not.
+// KiB is what the queries read (getCollisionWorldBytes).
+// Exits with 1 if the structures disagree on any query. Quantized results
+// only approximate the others, so their differences are reported, not failed.
+#include "config.h"
+#include "math/CollisionScene.h"
+#include "math/CollisionTrace.h"
+#include "math/ContactCache.h"
+#include "math/PlayerCollision.h"
+#include "math/CollisionWorld.h"
+#include "scene/CollisionMeshLoader.h"
+#include "utils/WorkerPool.h"
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const float QUERY_RADIUS = Config::PLAYER_RADIUS;
+const int QUERY_COUNT = 20000;
+const int TILE_COUNTS[] = {1, 2, 4, 8};
+// Synthetic walk: players, each walking this many ticks at 60 Hz
+const int WALKER_COUNT = 32;
+const int WALK_TICKS = 600;
+const float WALK_TICK_SECONDS = 1.0f / 60.0f;
+// Height of the lift motion in the move workload
+const float MOVE_AMPLITUDE = 3.0f;
+// Results differing by more than this count as disagreement between structures
+const float RESULT_TOLERANCE = 1e-4f;
+// Quantized results further than this from the exact ones are reported
+const float QUANTIZED_RESULT_TOLERANCE = 1e-2f;
+// Random triangles tried for a surface point before giving up on the level
+const int SURFACE_PICK_ATTEMPTS = 100000;
+
+// The timed loops add their results here, so the calls can't be optimized out
+volatile float result_sink = 0.0f;
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Where the copies of the level go on a grid emulating bigger maps
+std::vector<glm::vec3> getTileOffsets(const std::vector<Collision::Triangle>& triangles, int tiles_per_side) {
+    Collision::AABB bounds = Collision::createEmptyAABB();
+    for (const auto& tri : triangles) Collision::expandAABB(bounds, Collision::getTriangleAABB(tri));
+    glm::vec3 extent = bounds.max - bounds.min;
+
+    std::vector<glm::vec3> offsets;
+    for (int x = 0; x < tiles_per_side; ++x) {
+        for (int z = 0; z < tiles_per_side; ++z) offsets.push_back(glm::vec3(x * extent.x, 0.0f, z * extent.z));
+    }
+    return offsets;
+}
+
+// Repeats the level on the tile grid, as one flat triangle list
+std::vector<Collision::Triangle> tileTriangles(const std::vector<Collision::Triangle>& triangles, int tiles_per_side) {
+    std::vector<Collision::Triangle> tiled;
+    tiled.reserve(triangles.size() * tiles_per_side * tiles_per_side);
+    for (const glm::vec3& offset : getTileOffsets(triangles, tiles_per_side)) {
+        for (const auto& tri : triangles) {
+            tiled.push_back({tri.v0 + offset, tri.v1 + offset, tri.v2 + offset});
+        }
+    }
+    return tiled;
+}
+
+// The same map as one shared level mesh plus an instance per tile
+Collision::CollisionScene createTiledScene(const std::vector<Collision::Triangle>& triangles, int tiles_per_side,
+                                           const Collision::CollisionWorldSettings& settings) {
+    Collision::CollisionScene scene;
+    uint32_t mesh =
+        Collision::addCollisionMesh(scene, Collision::createCollisionWorld(triangles, settings), "level");
+    for (const glm::vec3& offset : getTileOffsets(triangles, tiles_per_side)) {
+        glm::mat4 transform(1.0f);
+        transform[3] = glm::vec4(offset, 1.0f);
+        Collision::createCollisionInstance(scene, mesh, transform, true);
+    }
+    return scene;
+}
+
+// Random point on a random triangle, with its unit normal. Skips degenerate
+// triangles and, with min_normal_y > -1, ones too steep to stand on. Returns
+// false if SURFACE_PICK_ATTEMPTS triangles in a row were skipped.
+bool pickSurfacePoint(const std::vector<Collision::Triangle>& triangles, std::mt19937& rng, float min_normal_y,
+                      glm::vec3& surface_point, glm::vec3& surface_normal) {
+    std::uniform_int_distribution<size_t> pick(0, triangles.size() - 1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int attempt = 0; attempt < SURFACE_PICK_ATTEMPTS; ++attempt) {
+        const Collision::Triangle& tri = triangles[pick(rng)];
+        glm::vec3 normal = glm::cross(tri.v1 - tri.v0, tri.v2 - tri.v0);
+        float length = glm::length(normal);
+        if (length == 0.0f || normal.y / length < min_normal_y) continue;
+
+        float u = unit(rng), v = unit(rng);
+        if (u + v > 1.0f) {
+            u = 1.0f - u;
+            v = 1.0f - v;
+        }
+        surface_normal = normal / length;
+        surface_point = tri.v0 + u * (tri.v1 - tri.v0) + v * (tri.v2 - tri.v0);
+        return true;
+    }
+    std::printf("No triangle with a normal y of at least %g found in %d tries\n", min_normal_y,
+                SURFACE_PICK_ATTEMPTS);
+    return false;
+}
+
+// Sphere centres scattered just above/below random surface points, which is
+// where a walking character's queries land. Empty if the level has no
+// usable surface.
+std::vector<Collision::CollisionTraceQuery> makeScatterTrace(const std::vector<Collision::Triangle>& triangles,
+                                                             int count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Collision::CollisionTraceQuery> queries(count);
+    for (Collision::CollisionTraceQuery& query : queries) {
+        glm::vec3 surface, normal;
+        if (!pickSurfacePoint(triangles, rng, -1.0f, surface, normal)) return {};
+        query.type = Collision::CollisionTraceQueryType::Contact;
+        query.center = surface + normal * ((unit(rng) * 2.0f - 1.0f) * QUERY_RADIUS);
+        query.radius = QUERY_RADIUS;
+    }
+    return queries;
+}
+
+// Players dropped onto walkable surfaces, walking and turning at random.
+// Each tick runs the player collision stepSimulation runs, through the same
+// function, then the camera boom sweep, so the trajectories follow the level.
+// Empty if the level has nowhere to stand.
+std::vector<Collision::CollisionTraceQuery> makeWalkTrace(const Collision::CollisionWorld& world,
+                                                          const std::vector<Collision::Triangle>& triangles) {
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+    const float walk_speed = Config::MOVEMENT_SPEED * WALK_TICK_SECONDS;
+
+    std::vector<Collision::CollisionTraceQuery> queries;
+    queries.reserve(WALKER_COUNT * WALK_TICKS * 4);
+    for (int walker = 0; walker < WALKER_COUNT; ++walker) {
+        glm::vec3 position, normal;
+        if (!pickSurfacePoint(triangles, rng, 0.7f, position, normal)) return {};
+        position += up * 0.5f; // Feet
+        float heading = unit(rng) * 6.2831853f;
+        float y_velocity = 0.0f;
+        bool is_grounded = false;
+
+        for (int tick = 0; tick < WALK_TICKS; ++tick) {
+            Collision::stepPlayerCollision(
+                position, y_velocity, is_grounded, WALK_TICK_SECONDS,
+                [&](const glm::vec3& center, float radius, glm::vec3& contact_normal, float& depth) {
+                    Collision::CollisionTraceQuery contact;
+                    contact.type = Collision::CollisionTraceQueryType::Contact;
+                    contact.center = center;
+                    contact.radius = radius;
+                    queries.push_back(contact);
+                    return Collision::findDeepestSphereContact(world, center, radius, contact_normal, depth);
+                },
+                [&](const glm::vec3& center, float radius, const glm::vec3& motion, Collision::CastFilter filter,
+                    Collision::CollisionHit& hit) {
+                    Collision::CollisionTraceQuery sweep;
+                    sweep.type = Collision::CollisionTraceQueryType::Sweep;
+                    sweep.center = center;
+                    sweep.radius = radius;
+                    sweep.motion = motion;
+                    sweep.filter = filter;
+                    queries.push_back(sweep);
+                    return Collision::castCollisionSphere(world, center, radius, motion, hit, nullptr, filter);
+                });
+
+            // Input: walk, turning now and then
+            if (unit(rng) < 0.02f) heading += (unit(rng) - 0.5f) * 3.0f;
+            glm::vec3 forward(std::cos(heading), 0.0f, std::sin(heading));
+            position += forward * walk_speed;
+
+            // Camera boom from the head back to the orbit position
+            Collision::CollisionTraceQuery boom;
+            boom.type = Collision::CollisionTraceQueryType::Sweep;
+            boom.center = position + up;
+            boom.radius = Config::CAMERA_COLLISION_RADIUS;
+            boom.motion = up * 3.0f - forward * 5.0f;
+            queries.push_back(boom);
+
+            Collision::CollisionTraceQuery end_tick;
+            end_tick.type = Collision::CollisionTraceQueryType::Tick;
+            queries.push_back(end_tick);
+        }
+    }
+    return queries;
+}
+
+struct WorkloadResult {
+    size_t query_count = 0; // Ticks excluded
+    double ns_per_query = 0.0;
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+    Collision::CollisionQueryStats stats;
+    std::vector<float> results; // Per trace entry, from runBenchQuery
+};
+
+// The scene plus one player's contact cache, queried as runEngine does: the
+// player-sized contacts and fall sweeps go through the cache, the camera
+// boom sweep doesn't
+struct CachedScene {
+    const Collision::CollisionScene* scene;
+    Collision::ContactCache* cache;
+};
+
+float runBenchQuery(const Collision::CollisionWorld& world, const Collision::CollisionTraceQuery& query,
+                    Collision::CollisionQueryStats* stats = nullptr) {
+    return Collision::runCollisionTraceQuery(world, query, stats);
+}
+
+float runBenchQuery(const Collision::CollisionScene& scene, const Collision::CollisionTraceQuery& query,
+                    Collision::CollisionQueryStats* stats = nullptr) {
+    return Collision::runCollisionTraceQuery(scene, query, stats);
+}
+
+float runBenchQuery(const CachedScene& cached, const Collision::CollisionTraceQuery& query,
+                    Collision::CollisionQueryStats* stats = nullptr) {
+    if (query.radius != QUERY_RADIUS) return Collision::runCollisionTraceQuery(*cached.scene, query, stats);
+    if (query.type == Collision::CollisionTraceQueryType::Contact) {
+        glm::vec3 normal(0.0f);
+        float depth = 0.0f;
+        return Collision::findDeepestSphereContact(*cached.scene, *cached.cache, query.center, query.radius, normal,
+                                                   depth, stats)
+                   ? depth
+                   : -1.0f;
+    }
+    Collision::CollisionHit hit;
+    return Collision::castCollisionSphere(*cached.scene, *cached.cache, query.center, query.radius, query.motion,
+                                          hit, stats, query.filter)
+               ? hit.t
+               : -1.0f;
+}
+
+// Structure: a CollisionWorld, a CollisionScene or a CachedScene
+template <typename Structure>
+WorkloadResult runWorkload(const Structure& world, const std::vector<Collision::CollisionTraceQuery>& queries) {
+    WorkloadResult result;
+    result.results.resize(queries.size());
+
+    // Counters, in an untimed pass
+    for (size_t i = 0; i < queries.size(); ++i) {
+        result.results[i] = runBenchQuery(world, queries[i], &result.stats);
+    }
+    result.query_count = result.stats.queries;
+    if (result.query_count == 0) return result;
+
+    // Throughput: one timed loop, as runEngine makes the calls
+    float sink = 0.0f;
+    Clock::time_point start = Clock::now();
+    for (const Collision::CollisionTraceQuery& query : queries) {
+        sink += runBenchQuery(world, query);
+    }
+    result.ns_per_query = elapsedMs(start) * 1.0e6 / result.query_count;
+
+    // Latency: each query timed on its own
+    std::vector<double> latencies;
+    latencies.reserve(result.query_count);
+    for (const Collision::CollisionTraceQuery& query : queries) {
+        if (query.type == Collision::CollisionTraceQueryType::Tick) continue;
+        Clock::time_point query_start = Clock::now();
+        sink += runBenchQuery(world, query);
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - query_start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_ns = latencies[latencies.size() / 2];
+    result.p99_ns = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+
+    result_sink = result_sink + sink;
+    return result;
+}
+
+// findDeepestSphereContacts on the pool, for the scatter workload. Returns
+// ns per sphere; counts results differing from the single-sphere path.
+double runBatch(const Collision::CollisionWorld& world, const std::vector<Collision::CollisionTraceQuery>& queries,
+                WorkerPool& pool, int& mismatches) {
+    std::vector<Collision::CollisionSphere> spheres;
+    spheres.reserve(queries.size());
+    for (const Collision::CollisionTraceQuery& query : queries) spheres.push_back({query.center, query.radius});
+
+    std::vector<Collision::SphereContact> contacts;
+    Clock::time_point start = Clock::now();
+    Collision::findDeepestSphereContacts(world, spheres, contacts, &pool);
+    double ns_per_query = elapsedMs(start) * 1.0e6 / spheres.size();
+
+    mismatches = 0;
+    for (size_t i = 0; i < spheres.size(); ++i) {
+        glm::vec3 normal(0.0f);
+        float depth = 0.0f;
+        Collision::findDeepestSphereContact(world, spheres[i].center, spheres[i].radius, normal, depth);
+        if (contacts[i].depth != depth || contacts[i].normal != normal) ++mismatches;
+    }
+    return ns_per_query;
+}
+
+// Every tile of the scene bobbing like a lift, moved once per tick. Returns
+// ns per moveCollisionInstance.
+double runMoves(Collision::CollisionScene& scene, int& move_count) {
+    std::vector<glm::mat4> rest;
+    for (const Collision::CollisionInstance& instance : scene.instances) rest.push_back(instance.transform);
+
+    move_count = 0;
+    Clock::time_point start = Clock::now();
+    for (int tick = 0; tick < WALK_TICKS; ++tick) {
+        for (uint32_t i = 0; i < scene.instances.size(); ++i) {
+            glm::mat4 transform = rest[i];
+            transform[3].y += MOVE_AMPLITUDE * std::sin((tick + i * 7) * WALK_TICK_SECONDS);
+            Collision::moveCollisionInstance(scene, i, transform);
+            ++move_count;
+        }
+    }
+    return elapsedMs(start) * 1.0e6 / std::max(move_count, 1);
+}
+
+struct Workload {
+    const char* name;
+    const std::vector<Collision::CollisionTraceQuery>* queries;
+};
+
+void printWorkloadRow(int tiles, const char* backend, size_t triangle_count, double build_ms, size_t bytes,
+                      const char* workload, const WorkloadResult& result) {
+    double queries = static_cast<double>(std::max<size_t>(result.query_count, 1));
+    std::printf("%-6d %-7s %10zu %9.2f %8zu  %-8s %8zu %9.1f %8.0f %8.0f %10.1f %8.2f\n", tiles, backend,
+                triangle_count, build_ms, bytes / 1024, workload, result.query_count, result.ns_per_query,
+                result.p50_ns, result.p99_ns, result.stats.triangles_returned / queries,
+                result.stats.triangles_hit / queries);
+}
+
+// Compares every workload's results between two structures
+int countDisagreements(const std::vector<WorkloadResult>& a, const std::vector<WorkloadResult>& b,
+                       float tolerance = RESULT_TOLERANCE) {
+    int disagreements = 0;
+    for (size_t w = 0; w < a.size(); ++w) {
+        for (size_t i = 0; i < a[w].results.size(); ++i) {
+            if (std::fabs(a[w].results[i] - b[w].results[i]) > tolerance) ++disagreements;
+        }
+    }
+    return disagreements;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "../src/assets/castle.gltf";
+    std::vector<Collision::Triangle> level = loadCollisionTriangles(path);
+    if (level.empty()) {
+        std::printf("No triangles loaded from %s\n", path.c_str());
+        return 1;
+    }
+    std::vector<Collision::CollisionTraceQuery> recorded;
+    if (argc > 2 && !Collision::loadCollisionTrace(argv[2], recorded)) {
+        std::printf("Could not load trace %s\n", argv[2]);
+        return 1;
+    }
+
+    std::unique_ptr<WorkerPool> pool = createWorkerPool();
+    std::printf("%s: %zu triangles, narrow phase %s, %d threads\n\n", path.c_str(), level.size(),
+                MathUtils::getSimdLevelName(MathUtils::getSimdLevel()), getWorkerPoolThreadCount(*pool));
+    std::printf("%-6s %-7s %10s %9s %8s  %-8s %8s %9s %8s %8s %10s %8s\n", "tiles", "backend", "triangles",
+                "build ms", "KiB", "workload", "queries", "ns/query", "p50 ns", "p99 ns", "tris/query", "hits/q");
+
+    bool disagreed = false;
+    for (int tiles : TILE_COUNTS) {
+        std::vector<Collision::Triangle> triangles = tileTriangles(level, tiles);
+
+        Collision::CollisionWorldSettings settings[4];
+        settings[1].octree_looseness = 1.5f;
+        settings[2].backend = Collision::CollisionBackend::Bvh;
+        settings[3].octree_looseness = 1.5f;
+        settings[3].quantize_triangles = true;
+        const char* names[4] = {"octree", "loose", "bvh", "quant"};
+
+        // Workloads are fixed per map before timing anything; the walk is
+        // simulated against the BVH but replayed unchanged on every structure
+        std::vector<Collision::CollisionTraceQuery> scatter = makeScatterTrace(triangles, QUERY_COUNT);
+        std::vector<Collision::CollisionTraceQuery> walk =
+            makeWalkTrace(Collision::createCollisionWorld(triangles, settings[2]), triangles);
+        if (scatter.empty() || walk.empty()) {
+            std::printf("No surface in %s to run the workloads on\n", path.c_str());
+            return 1;
+        }
+        std::vector<Workload> workloads = {{"scatter", &scatter}, {"walk", &walk}};
+        // The first tile sits where the level does, so the trace applies to every map size
+        if (!recorded.empty()) workloads.push_back({"trace", &recorded});
+
+        std::vector<WorkloadResult> results[4];
+        for (int b = 0; b < 4; ++b) {
+            Clock::time_point start = Clock::now();
+            Collision::CollisionWorld world = Collision::createCollisionWorld(triangles, settings[b]);
+            double build_ms = elapsedMs(start);
+            size_t bytes = Collision::getCollisionWorldBytes(world);
+
+            for (const Workload& workload : workloads) {
+                results[b].push_back(runWorkload(world, *workload.queries));
+                printWorkloadRow(tiles * tiles, names[b], triangles.size(), build_ms, bytes, workload.name,
+                                 results[b].back());
+            }
+
+            int batch_mismatches = 0;
+            double batch_ns = runBatch(world, scatter, *pool, batch_mismatches);
+            std::printf("%-6s %-7s %10s %9s %8s  %-8s %8zu %9.1f\n", "", "", "", "", "", "batch", scatter.size(),
+                        batch_ns);
+            if (batch_mismatches > 0) {
+                std::printf("       WARNING: %d batch results differ from the single-sphere path\n",
+                            batch_mismatches);
+                disagreed = true;
+            }
+        }
+
+        // The same map as instances of one mesh; no tile's triangles are
+        // copied. Tiles are movable so they can be moved afterwards.
+        Clock::time_point scene_start = Clock::now();
+        Collision::CollisionScene scene = createTiledScene(level, tiles, settings[1]);
+        double scene_build_ms = elapsedMs(scene_start);
+        size_t scene_bytes = scene.tree.nodes.size() * sizeof(Collision::AabbTreeNode) +
+                             scene.instances.size() * sizeof(Collision::CollisionInstance);
+        for (const Collision::CollisionWorld& mesh : scene.meshes) {
+            scene_bytes += Collision::getCollisionWorldBytes(mesh);
+        }
+        std::vector<WorkloadResult> scene_results;
+        for (const Workload& workload : workloads) {
+            scene_results.push_back(runWorkload(scene, *workload.queries));
+            printWorkloadRow(tiles * tiles, "scene", triangles.size(), scene_build_ms, scene_bytes, workload.name,
+                             scene_results.back());
+        }
+        Collision::ContactCache cache;
+        CachedScene cached = {&scene, &cache};
+        std::vector<WorkloadResult> cached_results;
+        for (const Workload& workload : workloads) {
+            Collision::resetContactCache(cache);
+            cached_results.push_back(runWorkload(cached, *workload.queries));
+            printWorkloadRow(tiles * tiles, "cached", triangles.size(), scene_build_ms, scene_bytes, workload.name,
+                             cached_results.back());
+        }
+        std::printf("%-6s %-7s %10s %9s %8s  %-8s %8s %9s  answered %llu, refilled %llu\n", "", "", "", "", "",
+                    "cache", "", "", static_cast<unsigned long long>(cache.answers),
+                    static_cast<unsigned long long>(cache.refills));
+
+        int move_count = 0;
+        double move_ns = runMoves(scene, move_count);
+        const Collision::DynamicAabbTree& tree = scene.tree;
+        std::printf("%-6s %-7s %10s %9s %8s  %-8s %8d %9.1f  absorbed %llu, refit %llu, reinserted %llu\n", "", "",
+                    "", "", "", "move", move_count, move_ns, static_cast<unsigned long long>(tree.moves_absorbed),
+                    static_cast<unsigned long long>(tree.refits), static_cast<unsigned long long>(tree.reinserts));
+
+        // All structures must report the same contacts and impacts
+        int disagreements = countDisagreements(results[0], results[2]) + countDisagreements(results[1], results[2]) +
+                            countDisagreements(scene_results, results[2]) +
+                            countDisagreements(cached_results, results[2]);
+        if (disagreements > 0) {
+            std::printf("       WARNING: %d queries disagree between structures\n", disagreements);
+            disagreed = true;
+        }
+        int quantized_differences = countDisagreements(results[3], results[2], QUANTIZED_RESULT_TOLERANCE);
+        if (quantized_differences > 0) {
+            std::printf("       quant: %d queries differ from the exact result by more than %g\n",
+                        quantized_differences, QUANTIZED_RESULT_TOLERANCE);
+        }
+    }
+    return disagreed ? 1 : 0;
+}
@@ -22,14 +22,69 @@ const float LIGHT_SPHERE_SCALE = 1.0f;
 const float FIELD_OF_VIEW = 90.0f;
 const float MOUSE_SENSITIVITY = 0.05f;
 const float MOVEMENT_SPEED = 20.0f;
+// Radius swept along the third-person camera boom to keep it out of walls
+const float CAMERA_COLLISION_RADIUS = 0.2f;
+
+// Simulation: physics, input and animation advance in fixed ticks of
+// 1 / SIMULATION_TICK_RATE seconds whatever the frame rate; rendering
+// interpolates between the last two ticks
+const float SIMULATION_TICK_RATE = 60.0f;
+// Most ticks run per frame. After a longer stall the rest of the backlog is
+// dropped (the game slows down) rather than spending ever longer frames
+// catching up.
+const int SIMULATION_MAX_STEPS = 5;
 
 // Physics Settings
 const float GRAVITY_STRENGTH = 9.81f;
 const float PLAYER_RADIUS = 1.2f; // Radius of the player's collision sphere
 const float JUMP_STRENGTH = 5.0f; // Initial vertical velocity for a jump
+// Gap left between the player sphere and the surface it was swept into
+const float PLAYER_CONTACT_SKIN = 0.001f;
+// How far past the player's query box its contact cache gathers triangles.
+// Bigger refills less often but tests more triangles per query.
+const float PLAYER_CONTACT_CACHE_MARGIN = 1.0f;
+
+// Collision acceleration structure for the static level: "octree" or "bvh"
+const char *const COLLISION_BACKEND = "octree";
+// Loose octree child factor (1.0 = tight); root bounds fit the level
+const float COLLISION_OCTREE_LOOSENESS = 1.5f;
+// Voxel size of the baked distance field used for approximate (crowd)
+// sphere contacts; 0 skips the bake. Answers spheres up to PLAYER_RADIUS.
+const float COLLISION_SDF_VOXEL_SIZE = 0.0f;
+// Store collision triangles as 16-bit positions relative to their octree
+// node (or BVH leaf) plus shared-vertex indices, decoded per query: several
+// times less memory, positions off by at most 1/131070 of a node's size
+const bool COLLISION_QUANTIZE_TRIANGLES = true;
+// Where baked collision structures go, one per static mesh asset, named after
+// it (castle.gltf -> castle.collision); empty is the working directory.
+// Rebuilt and rewritten when the asset or the settings above change.
+const char *const COLLISION_CACHE_DIRECTORY = "";
+// Seconds between collision stats log lines (query counters averaged per
+// frame); also prints the octree's shape at load. 0 disables.
+const float COLLISION_STATS_LOG_INTERVAL = 0.0f;
+// If set, every collision query made while playing is recorded and written
+// here on exit, for replay in collision-bench. Empty disables recording.
+const char *const COLLISION_TRACE_PATH = "";
 
 // Animation
 const float PLAYER_ANIMATION_SPEED = 2.0f;
+// Clip of the player's file to play, by name; the first one if not found
+const char *const PLAYER_ANIMATION_CLIP = "";
+// Frames per second clips are resampled to at load. Resampled clips are
+// stored as SoA streams on a uniform grid, quantized to 18 bytes per joint
+// and frame (against 40 as floats), and decoded and sampled for all joints
+// at once with SIMD, in constant time however long the clip. Streams store
+// every frame of every joint, moving or not, so a clip is only resampled if
+// its streams take no more memory than its compressed keys (below): dense
+// clips, like motion capture, are; sparse or mostly still ones keep their
+// keys. 0 never resamples.
+const float ANIMATION_RESAMPLE_RATE = 60.0f;
+// Clips that aren't resampled have their keys compressed to about 8 bytes
+// each, dropping keys interpolation reproduces within this tolerance (units
+// of translation/scale, radians of rotation). Sampled one joint at a time,
+// searching on from where the previous update left off. 0 keeps the
+// imported keys as they are.
+const float ANIMATION_COMPRESSION_TOLERANCE = 0.001f;
 
 // Dynamic Light Position (for main light source)
 const float DYNAMIC_LIGHT_POS_X = 0.0f;
@@ -30,6 +30,21 @@ Camera createCamera(glm::vec3 position, glm::vec3 up, float yaw, float pitch) {
     return camera;
 }
 
+glm::vec3 getCameraOrbitTarget(const glm::vec3 &player_position) {
+    return player_position +
+           glm::vec3(0.0f, 1.0f, 0.0f); // Look at head/shoulders
+}
+
+glm::vec3 getCameraOrbitOffset(const Camera &camera) {
+    // Calculate Orbit Position based on Yaw/Pitch
+    glm::mat4 rotation = glm::mat4(1.0f);
+    rotation = glm::rotate(rotation, glm::radians(camera.yaw),
+                           glm::vec3(0.0f, 1.0f, 0.0f));
+    rotation = glm::rotate(rotation, glm::radians(camera.pitch),
+                           glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::vec3(rotation * glm::vec4(camera.player_offset, 0.0f));
+}
+
 glm::mat4 getCameraViewMatrix(Camera &camera, const GameState &state) {
 
     // 1. PLAYER VIEW: Orbit Logic
@@ -37,20 +52,13 @@ glm::mat4 getCameraViewMatrix(Camera &camera, const GameState &state) {
         state.player_object_index != -1) {
         const SceneObject &player =
             state.scene_objects[state.player_object_index];
-        glm::vec3 camera_target =
-            player.position +
-            glm::vec3(0.0f, 1.0f, 0.0f); // Look at head/shoulders
-
-        // Calculate Orbit Position based on Yaw/Pitch
-        glm::mat4 rotation = glm::mat4(1.0f);
-        rotation = glm::rotate(rotation, glm::radians(camera.yaw),
-                               glm::vec3(0.0f, 1.0f, 0.0f));
-        rotation = glm::rotate(rotation, glm::radians(camera.pitch),
-                               glm::vec3(1.0f, 0.0f, 0.0f));
+        // Follows the player as drawn, between simulation ticks
+        glm::vec3 camera_target = getCameraOrbitTarget(
+            getSceneObjectRenderPosition(player, state.interpolation_alpha));
 
-        glm::vec3 rotated_offset =
-            glm::vec3(rotation * glm::vec4(camera.player_offset, 0.0f));
-        glm::vec3 orbit_pos = camera_target - rotated_offset;
+        // Pulled in along the boom when the engine found geometry in the way
+        glm::vec3 orbit_pos =
+            camera_target - getCameraOrbitOffset(camera) * camera.boom_fraction;
 
         // SYNC: Update the actual camera struct so the rest of the engine knows
         // where we are
@@ -61,9 +69,10 @@ glm::mat4 getCameraViewMatrix(Camera &camera, const GameState &state) {
 
     // 2. FREE VIEW: Standard FPS Logic
     // In this mode, camera.position is modified by WASD in
-    // processCameraKeyboard
-    return glm::lookAt(camera.position, camera.position + camera.front,
-                       camera.up);
+    // processCameraKeyboard, once per simulation tick
+    glm::vec3 eye = glm::mix(camera.previous_position, camera.position,
+                             state.interpolation_alpha);
+    return glm::lookAt(eye, eye + camera.front, camera.up);
 }
 
 void processCameraKeyboard(Camera &camera, CameraMovement direction,
@@ -22,6 +22,11 @@ struct Camera {
     float zoom;
     CameraMode current_mode = PLAYER_VIEW;
     glm::vec3 player_offset = glm::vec3(0.0f, 3.0f, 5.0f);
+    // Fraction of the orbit offset that is free of level geometry; set each
+    // frame by the engine so the camera never ends up behind a wall
+    float boom_fraction = 1.0f;
+    // Free view position at the start of the latest simulation tick
+    glm::vec3 previous_position = glm::vec3(0.0f);
     float last_tick_camera_toggle_time = 0.0f;
 };
 
@@ -31,6 +36,11 @@ Camera createCamera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f),
 
 glm::mat4 getCameraViewMatrix(Camera &camera, const GameState &state);
 
+// Third-person orbit: the point looked at, and the (unclipped) offset from
+// the camera to it
+glm::vec3 getCameraOrbitTarget(const glm::vec3 &player_position);
+glm::vec3 getCameraOrbitOffset(const Camera &camera);
+
 void processCameraKeyboard(Camera &camera, CameraMovement direction,
                            float delta_time);
 void processCameraMouse(Camera &camera, float x_offset, float y_offset,
@@ -1,12 +1,15 @@
 #define GLFW_INCLUDE_NONE
 #include "Engine.h"
+#include <cmath>
 #include <glad/gl.h>
 #include <iostream>
 
 #include <glm/gtc/quaternion.hpp>
 
 #include "../config.h"
+#include "../math/CollisionCache.h"
 #include "../math/GeometryUtils.h"
+#include "../math/PlayerCollision.h"
 #include "../render/Animation.h"
 #include "../render/Renderer.h"
 #include "../scene/Scene.h"
@@ -38,6 +41,57 @@ void initGLAD() {
         exit(-1);
 }
 
+// Collision mesh for a static model, shared by every object using the same
+// asset. Mapped from the asset's cache file if that is still current,
+// otherwise built from the model's triangles (model space) and cached.
+uint32_t getCollisionMesh(Engine &engine, const Model &model,
+                          const Collision::CollisionWorldSettings &settings) {
+    uint32_t shared =
+        Collision::findCollisionMesh(engine.collision_scene, model.source_path);
+    if (shared != Collision::COLLISION_NULL_MESH)
+        return shared;
+
+    std::vector<Collision::Triangle> collision_triangles;
+    for (const auto &mesh : model.meshes) {
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            Collision::Triangle tri;
+            tri.v0 = mesh.vertices[mesh.indices[i + 0]].position;
+            tri.v1 = mesh.vertices[mesh.indices[i + 1]].position;
+            tri.v2 = mesh.vertices[mesh.indices[i + 2]].position;
+            collision_triangles.push_back(tri);
+        }
+    }
+
+    std::string cache_path = Collision::getCollisionCachePath(
+        Config::COLLISION_CACHE_DIRECTORY, model.source_path);
+    uint64_t collision_hash =
+        Collision::hashCollisionSource(collision_triangles, settings);
+    Collision::CollisionWorld world;
+    bool cached =
+        Collision::loadCollisionCache(cache_path, collision_hash, world);
+    if (!cached) {
+        world = Collision::createCollisionWorld(collision_triangles, settings);
+        Collision::writeCollisionCache(cache_path, world, collision_hash);
+    }
+
+    std::cout << "Collision mesh " << model.source_path << ": "
+              << Collision::getCollisionTriangleCount(world) << " triangles, "
+              << Collision::getCollisionBackendName(world.backend)
+              << (world.quantized.block_count > 0 ? " quantized" : "")
+              << (cached ? " (cached)" : "") << ", "
+              << Collision::getCollisionWorldBytes(world) / 1024 << " KiB";
+    if (world.sdf.brick_count > 0) {
+        std::cout << ", distance field " << world.sdf.brick_count << " bricks";
+    }
+    std::cout << std::endl;
+    if (Config::COLLISION_STATS_LOG_INTERVAL > 0.0f &&
+        world.backend == Collision::CollisionBackend::Octree) {
+        Collision::printOctreeStats(Collision::getOctreeStats(world.octree));
+    }
+    return Collision::addCollisionMesh(engine.collision_scene, std::move(world),
+                                       model.source_path);
+}
+
 void initResources(Engine &engine) {
     engine.state.camera = createCamera(glm::vec3(
         Config::CAM_START_X, Config::CAM_START_Y, Config::CAM_START_Z));
@@ -50,34 +104,82 @@ void initResources(Engine &engine) {
     engine.state.delta_time = 0.0f;
 
     loadScene(engine.state);
+    savePreviousTransforms(engine.state);
+    for (SceneObject &object : engine.state.scene_objects) {
+        object.contact_cache.margin = Config::PLAYER_CONTACT_CACHE_MARGIN;
+    }
 
     // --- ANIMATION INIT ---
     if (engine.state.player_object_index != -1) {
         SceneObject &player =
             engine.state.scene_objects[engine.state.player_object_index];
-        // Load the animation from the player GLB file
-        engine.state.player_animation =
-            loadAnimation("../src/assets/player.glb", &player.model);
-        playAnimation(engine.state.player_animator,
-                      &engine.state.player_animation);
+        // Load the animations from the player GLB file
+        AnimationLoadSettings animation_settings;
+        animation_settings.resample_rate = Config::ANIMATION_RESAMPLE_RATE;
+        animation_settings.compression_tolerance =
+            Config::ANIMATION_COMPRESSION_TOLERANCE;
+        AnimationLibrary &animations = engine.state.player_animations;
+        animations = loadAnimationLibrary("../src/assets/player.glb",
+                                          player.model, animation_settings);
+        size_t animation_bytes = 0;
+        size_t resampled_count = 0;
+        for (const Animation &clip : animations.clips) {
+            animation_bytes += getAnimationBytes(clip);
+            if (clip.streams.frame_count > 0)
+                ++resampled_count;
+        }
+        std::cout << "Player animations: " << animations.clips.size()
+                  << " clips (" << resampled_count << " resampled), "
+                  << animation_bytes / 1024 << " KiB" << std::endl;
+
+        Animation *clip =
+            findAnimation(animations, Config::PLAYER_ANIMATION_CLIP);
+        if (!clip && !animations.clips.empty())
+            clip = &animations.clips[0];
+        playAnimation(engine.state.player_animator, clip);
     }
     // ----------------------
 
-    engine.collision_octree = Collision::createOctree(
-        Collision::AABB{glm::vec3(-100), glm::vec3(100)}, 8, 8);
-    if (!engine.state.scene_objects.empty()) {
-        const SceneObject &castle = engine.state.scene_objects[0];
-        for (const auto &mesh : castle.model.meshes) {
-            for (size_t i = 0; i < mesh.indices.size(); i += 3) {
-                Collision::Triangle tri;
-                tri.v0 = mesh.vertices[mesh.indices[i + 0]].position;
-                tri.v1 = mesh.vertices[mesh.indices[i + 1]].position;
-                tri.v2 = mesh.vertices[mesh.indices[i + 2]].position;
-                Collision::insertTriangleIntoOctree(
-                    engine.collision_octree.root.get(), tri, 0, 8, 8);
+    Collision::CollisionWorldSettings collision_settings;
+    collision_settings.octree_looseness = Config::COLLISION_OCTREE_LOOSENESS;
+    collision_settings.sdf_voxel_size = Config::COLLISION_SDF_VOXEL_SIZE;
+    collision_settings.sdf_max_radius = Config::PLAYER_RADIUS;
+    collision_settings.quantize_triangles =
+        Config::COLLISION_QUANTIZE_TRIANGLES;
+    if (!Collision::parseCollisionBackend(Config::COLLISION_BACKEND,
+                                          collision_settings.backend)) {
+        std::cout << "Unknown collision backend '" << Config::COLLISION_BACKEND
+                  << "', using octree" << std::endl;
+    }
+
+    // Static objects become instances of one collision mesh per asset;
+    // everything else moves, so it goes into the broadphase
+    for (SceneObject &object : engine.state.scene_objects) {
+        if (object.model.meshes.empty())
+            continue;
+        if (object.is_static) {
+            object.collision_instance = Collision::createCollisionInstance(
+                engine.collision_scene,
+                getCollisionMesh(engine, object.model, collision_settings),
+                getSceneObjectMatrix(object), object.is_kinematic);
+            // The collision mesh has its own copy; the GPU has the rest
+            for (Mesh &mesh : object.model.meshes) {
+                std::vector<Vertex>().swap(mesh.vertices);
+                std::vector<unsigned int>().swap(mesh.indices);
             }
+        } else {
+            object.broadphase_proxy = Collision::createBroadphaseProxy(
+                engine.broadphase, getSceneObjectBounds(object));
         }
     }
+    std::cout << "Collision scene: " << engine.collision_scene.meshes.size()
+              << " meshes, "
+              << Collision::getCollisionInstanceCount(engine.collision_scene)
+              << " instances, narrow phase "
+              << MathUtils::getSimdLevelName(MathUtils::getSimdLevel())
+              << std::endl;
+    engine.collision_stats_start = engine.state.last_frame;
+
     engine.shader_program = createShaderProgram();
     engine.depth_shader_program = createDepthShaderProgram();
     engine.shadow_map = createShadowMap(1024, 1024);
@@ -98,82 +200,168 @@ Engine createEngine() {
     return engine;
 }
 
+// Adds a query to the trace when Config::COLLISION_TRACE_PATH is set
+void recordCollisionQuery(Engine &engine, Collision::CollisionTraceQueryType type,
+                          const glm::vec3 &center, float radius,
+                          const glm::vec3 &motion = glm::vec3(0.0f),
+                          Collision::CastFilter filter =
+                              Collision::CastFilter::All) {
+    if (Config::COLLISION_TRACE_PATH[0] == '\0')
+        return;
+    Collision::CollisionTraceQuery query;
+    query.type = type;
+    query.center = center;
+    query.radius = radius;
+    query.motion = motion;
+    query.filter = filter;
+    engine.collision_trace.push_back(query);
+}
+
+// One fixed simulation tick of engine.state.delta_time seconds: animation,
+// physics, input and everything that depends on them
+void stepSimulation(Engine &engine,
+                    Collision::CollisionQueryStats *collision_stats) {
+    savePreviousTransforms(engine.state);
+
+    // --- ANIMATION UPDATE ---
+    // APPLY CONFIG SPEED HERE
+    updateAnimator(engine.state.player_animator,
+                   engine.state.delta_time * Config::PLAYER_ANIMATION_SPEED);
+    // ------------------------
+
+    // --- MOVING LEVEL GEOMETRY ---
+    // Before the player's queries, so they see this tick's positions
+    for (const SceneObject &object : engine.state.scene_objects) {
+        if (object.is_kinematic &&
+            object.collision_instance != Collision::COLLISION_NULL_INSTANCE) {
+            Collision::moveCollisionInstance(engine.collision_scene,
+                                             object.collision_instance,
+                                             getSceneObjectMatrix(object));
+        }
+    }
+
+    // --- PHYSICS & COLLISION ---
+    // Both player queries (see stepPlayerCollision) go through its contact
+    // cache, which only walks the scene when the player leaves the region it
+    // gathered last time
+    if (engine.state.player_object_index != -1 &&
+        engine.state.camera.current_mode == PLAYER_VIEW) {
+        SceneObject &player =
+            engine.state.scene_objects[engine.state.player_object_index];
+        Collision::stepPlayerCollision(
+            player.position, player.y_velocity, player.is_grounded,
+            engine.state.delta_time,
+            [&](const glm::vec3 &center, float radius, glm::vec3 &normal,
+                float &depth) {
+                recordCollisionQuery(
+                    engine, Collision::CollisionTraceQueryType::Contact,
+                    center, radius);
+                return Collision::findDeepestSphereContact(
+                    engine.collision_scene, player.contact_cache, center,
+                    radius, normal, depth, collision_stats);
+            },
+            [&](const glm::vec3 &center, float radius, const glm::vec3 &motion,
+                Collision::CastFilter filter, Collision::CollisionHit &hit) {
+                recordCollisionQuery(engine,
+                                     Collision::CollisionTraceQueryType::Sweep,
+                                     center, radius, motion, filter);
+                return Collision::castCollisionSphere(
+                    engine.collision_scene, player.contact_cache, center,
+                    radius, motion, hit, collision_stats, filter);
+            });
+    }
+
+    // --- ROTATION SYNC ---
+    if (engine.state.player_object_index != -1 &&
+        engine.state.camera.current_mode == PLAYER_VIEW) {
+        float yaw = engine.state.camera.yaw;
+
+        // Adjust this offset (-90, +90, 0, 180) to align model back to camera
+        glm::quat yaw_rotation =
+            glm::angleAxis(glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        engine.state.scene_objects[engine.state.player_object_index]
+            .orientation = yaw_rotation;
+    }
+
+    processInput(engine.window, engine.state);
+
+    // --- BROADPHASE ---
+    for (const SceneObject &object : engine.state.scene_objects) {
+        if (object.broadphase_proxy != Collision::BROADPHASE_NULL_PROXY) {
+            Collision::moveBroadphaseProxy(engine.broadphase,
+                                           object.broadphase_proxy,
+                                           getSceneObjectBounds(object));
+        }
+    }
+    Collision::updateBroadphase(engine.broadphase, engine.broadphase_events);
+
+    // --- CAMERA BOOM ---
+    // Sweep from the player out to the orbit position and stop the camera
+    // at the first wall in between
+    Camera &camera = engine.state.camera;
+    camera.boom_fraction = 1.0f;
+    if (engine.state.player_object_index != -1 &&
+        camera.current_mode == PLAYER_VIEW) {
+        const SceneObject &player =
+            engine.state.scene_objects[engine.state.player_object_index];
+        Collision::CollisionHit boom_hit;
+        recordCollisionQuery(engine, Collision::CollisionTraceQueryType::Sweep,
+                             getCameraOrbitTarget(player.position),
+                             Config::CAMERA_COLLISION_RADIUS,
+                             -getCameraOrbitOffset(camera));
+        if (Collision::castCollisionSphere(
+                engine.collision_scene, getCameraOrbitTarget(player.position),
+                Config::CAMERA_COLLISION_RADIUS, -getCameraOrbitOffset(camera),
+                boom_hit, collision_stats)) {
+            camera.boom_fraction = boom_hit.t;
+        }
+    }
+
+    recordCollisionQuery(engine, Collision::CollisionTraceQueryType::Tick,
+                         glm::vec3(0.0f), 0.0f);
+}
+
 void runEngine(Engine &engine) {
+    const float tick_seconds = 1.0f / Config::SIMULATION_TICK_RATE;
     while (!glfwWindowShouldClose(engine.window)) {
         float current_frame = static_cast<float>(glfwGetTime());
-        engine.state.delta_time = current_frame - engine.state.last_frame;
+        engine.state.tick_accumulator +=
+            current_frame - engine.state.last_frame;
         engine.state.last_frame = current_frame;
 
-        // --- ANIMATION UPDATE ---
-        // APPLY CONFIG SPEED HERE
-        updateAnimator(engine.state.player_animator,
-                       engine.state.delta_time *
-                           Config::PLAYER_ANIMATION_SPEED);
-        // ------------------------
-
-        // --- PHYSICS & COLLISION ---
-        if (engine.state.player_object_index != -1 &&
-            engine.state.camera.current_mode == PLAYER_VIEW) {
-            SceneObject &player =
-                engine.state.scene_objects[engine.state.player_object_index];
-            player.is_grounded = false;
-
-            player.y_velocity -=
-                Config::GRAVITY_STRENGTH * engine.state.delta_time;
-            player.position.y += player.y_velocity * engine.state.delta_time;
-
-            glm::vec3 center =
-                player.position + glm::vec3(0.0f, Config::PLAYER_RADIUS, 0.0f);
-            Collision::AABB query = {
-                center - glm::vec3(Config::PLAYER_RADIUS + 0.1f),
-                center + glm::vec3(Config::PLAYER_RADIUS + 0.1f)};
-            std::vector<Collision::Triangle> tris;
-            Collision::getTrianglesFromOctree(
-                engine.collision_octree.root.get(), query, tris);
-
-            glm::vec3 final_normal(0.0f);
-            float max_depth = 0.0f;
-            bool hit = false;
-
-            for (const auto &tri : tris) {
-                glm::vec3 norm;
-                float depth;
-                if (MathUtils::checkSphereTriangleCollision(
-                        center, Config::PLAYER_RADIUS, tri, norm, depth)) {
-                    if (depth > max_depth) {
-                        max_depth = depth;
-                        final_normal = norm;
-                        hit = true;
-                    }
-                }
-            }
-
-            if (hit) {
-                player.position += final_normal * max_depth;
-                if (final_normal.y > 0.5f) {
-                    player.y_velocity = 0.0f;
-                    player.is_grounded = true;
-                } else if (final_normal.y < 0.1f) {
-                    player.y_velocity = 0.0f;
-                }
-            }
+        // --- SIMULATION ---
+        Collision::CollisionQueryStats *collision_stats =
+            Config::COLLISION_STATS_LOG_INTERVAL > 0.0f
+                ? &engine.collision_stats
+                : nullptr;
+        engine.state.delta_time = tick_seconds;
+        int steps = 0;
+        while (engine.state.tick_accumulator >= tick_seconds &&
+               steps < Config::SIMULATION_MAX_STEPS) {
+            stepSimulation(engine, collision_stats);
+            engine.state.tick_accumulator -= tick_seconds;
+            ++steps;
         }
+        if (engine.state.tick_accumulator >= tick_seconds) {
+            engine.state.tick_accumulator =
+                std::fmod(engine.state.tick_accumulator, tick_seconds);
+        }
+        engine.state.interpolation_alpha =
+            engine.state.tick_accumulator / tick_seconds;
 
-        // --- ROTATION SYNC ---
-        if (engine.state.player_object_index != -1 &&
-            engine.state.camera.current_mode == PLAYER_VIEW) {
-            float yaw = engine.state.camera.yaw;
-
-            // Adjust this offset (-90, +90, 0, 180) to align model back to
-            // camera
-            glm::quat yaw_rotation =
-                glm::angleAxis(glm::radians(yaw), glm::vec3(0.0f, 1.0f, 0.0f));
-
-            engine.state.scene_objects[engine.state.player_object_index]
-                .orientation = yaw_rotation;
+        if (collision_stats) {
+            ++engine.collision_stats_frames;
+            if (current_frame - engine.collision_stats_start >=
+                Config::COLLISION_STATS_LOG_INTERVAL) {
+                Collision::printCollisionQueryStats(
+                    engine.collision_stats, engine.collision_stats_frames);
+                engine.collision_stats = Collision::CollisionQueryStats();
+                engine.collision_stats_frames = 0;
+                engine.collision_stats_start = current_frame;
+            }
         }
 
-        processInput(engine.window, engine.state);
         renderScene(engine.window, engine.state, engine.shader_program,
                     engine.depth_shader_program, engine.shadow_map,
                     engine.light_sphere_vao, engine.light_sphere_vertex_count);
@@ -182,4 +370,13 @@ void runEngine(Engine &engine) {
     }
 }
 
-void cleanupEngine(Engine &engine) { glfwTerminate(); }
+void cleanupEngine(Engine &engine) {
+    if (!engine.collision_trace.empty() &&
+        Collision::writeCollisionTrace(Config::COLLISION_TRACE_PATH,
+                                       engine.collision_trace)) {
+        std::cout << "Collision trace: " << engine.collision_trace.size()
+                  << " queries written to " << Config::COLLISION_TRACE_PATH
+                  << std::endl;
+    }
+    glfwTerminate();
+}
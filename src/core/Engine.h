@@ -5,7 +5,10 @@
 #include "State.h"
 #include "../render/ShaderProgram.h"
 #include "../render/ShadowMap.h"
-#include "../math/Octree.h" // For Collision::Octree
+#include "../math/Broadphase.h"
+#include "../math/CollisionTrace.h"
+#include "../math/CollisionScene.h"
+#include <vector>
 
 struct Engine {
     GLFWwindow* window;
@@ -15,7 +18,18 @@ struct Engine {
     ShadowMap shadow_map;
     unsigned int light_sphere_vao;
     unsigned int light_sphere_vertex_count;
-    Collision::Octree collision_octree; // For collision detection
+    // Static level geometry: per-asset collision meshes and their instances
+    Collision::CollisionScene collision_scene;
+    // Query counters since the last stats log (Config::COLLISION_STATS_LOG_INTERVAL)
+    Collision::CollisionQueryStats collision_stats;
+    uint64_t collision_stats_frames = 0;
+    float collision_stats_start = 0.0f;
+    // Queries recorded for Config::COLLISION_TRACE_PATH
+    std::vector<Collision::CollisionTraceQuery> collision_trace;
+    // Object-vs-object overlaps between the dynamic scene objects, and the
+    // pairs that began/persisted/ended on the latest tick
+    Collision::Broadphase broadphase;
+    Collision::BroadphasePairEvents broadphase_events;
 };
 
 Engine createEngine();
@@ -14,12 +14,16 @@ struct GameState {
     float last_x;
     float last_y;
     bool first_mouse;
-    float delta_time;
+    float delta_time; // Simulation tick length while ticking
     float last_frame;
+    // Frame time not yet simulated, under one tick once the frame's ticks ran
+    float tick_accumulator = 0.0f;
+    // Where rendering sits between the previous tick (0) and the latest (1)
+    float interpolation_alpha = 1.0f;
     int player_object_index = -1; // Index of the player SceneObject
 
     // Animation State
-    Animation player_animation;
+    AnimationLibrary player_animations;
     Animator player_animator;
 };
 
@@ -0,0 +1,205 @@
+#include "AabbTree.h"
+#include <algorithm>
+
+namespace Collision {
+
+AABB combineAABB(const AABB& a, const AABB& b) {
+    AABB combined = a;
+    expandAABB(combined, b);
+    return combined;
+}
+
+uint32_t allocateAabbTreeNode(DynamicAabbTree& tree) {
+    if (tree.free_list == AABB_TREE_NULL_NODE) {
+        tree.nodes.emplace_back();
+        return static_cast<uint32_t>(tree.nodes.size() - 1);
+    }
+    uint32_t index = tree.free_list;
+    tree.free_list = tree.nodes[index].parent;
+    tree.nodes[index] = AabbTreeNode();
+    return index;
+}
+
+void freeAabbTreeNode(DynamicAabbTree& tree, uint32_t index) {
+    tree.nodes[index] = AabbTreeNode();
+    tree.nodes[index].parent = tree.free_list;
+    tree.free_list = index;
+}
+
+// Points the parent of `old_child` (or the root) at `new_child`
+void replaceAabbTreeChild(DynamicAabbTree& tree, uint32_t parent, uint32_t old_child, uint32_t new_child) {
+    if (parent == AABB_TREE_NULL_NODE) {
+        tree.root = new_child;
+        return;
+    }
+    AabbTreeNode& node = tree.nodes[parent];
+    node.children[node.children[0] == old_child ? 0 : 1] = new_child;
+}
+
+void updateAabbTreeNode(DynamicAabbTree& tree, uint32_t index) {
+    AabbTreeNode& node = tree.nodes[index];
+    const AabbTreeNode& a = tree.nodes[node.children[0]];
+    const AabbTreeNode& b = tree.nodes[node.children[1]];
+    node.bounds = combineAABB(a.bounds, b.bounds);
+    node.height = 1 + std::max(a.height, b.height);
+}
+
+// While one child of `index` is more than one level taller than the other,
+// rotates the taller child up into its place. Returns the node now at
+// `index`'s position.
+uint32_t balanceAabbTreeNode(DynamicAabbTree& tree, uint32_t index) {
+    // Children are already up to date on the refit path; the node itself
+    // may not be yet
+    for (;;) {
+        const AabbTreeNode& node = tree.nodes[index];
+        if (isAabbTreeLeaf(node)) return index;
+
+        int balance = tree.nodes[node.children[1]].height - tree.nodes[node.children[0]].height;
+        if (balance >= -1 && balance <= 1) return index;
+
+        // The taller child moves up; of its children, the taller one stays
+        // with it and the shorter one is handed down to `index`
+        int up_side = balance > 1 ? 1 : 0;
+        uint32_t up = node.children[up_side];
+        uint32_t up_a = tree.nodes[up].children[0];
+        uint32_t up_b = tree.nodes[up].children[1];
+        uint32_t keep = tree.nodes[up_a].height > tree.nodes[up_b].height ? up_a : up_b;
+        uint32_t give = keep == up_a ? up_b : up_a;
+
+        uint32_t parent = tree.nodes[index].parent;
+        replaceAabbTreeChild(tree, parent, index, up);
+        tree.nodes[up].parent = parent;
+        tree.nodes[up].children[0] = index;
+        tree.nodes[up].children[1] = keep;
+        tree.nodes[index].parent = up;
+        tree.nodes[index].children[up_side] = give;
+        tree.nodes[give].parent = index;
+
+        // One rotation only fixes a two-level difference. A leaf inserted
+        // next to a tall subtree makes a bigger one, which leaves `index`
+        // and then `up` lopsided in turn.
+        updateAabbTreeNode(tree, balanceAabbTreeNode(tree, index));
+        updateAabbTreeNode(tree, up);
+        index = up;
+    }
+}
+
+// Refits bounds and heights from `index` to the root, rebalancing on the way
+void refitAabbTreeAncestors(DynamicAabbTree& tree, uint32_t index) {
+    while (index != AABB_TREE_NULL_NODE) {
+        index = balanceAabbTreeNode(tree, index);
+        updateAabbTreeNode(tree, index);
+        index = tree.nodes[index].parent;
+    }
+}
+
+// Links an allocated leaf into the tree next to its cheapest sibling
+void insertAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf) {
+    tree.nodes[leaf].parent = AABB_TREE_NULL_NODE;
+    if (tree.root == AABB_TREE_NULL_NODE) {
+        tree.root = leaf;
+        tree.nodes[leaf].reference_area = getAABBHalfArea(tree.nodes[leaf].bounds);
+        return;
+    }
+    const AABB bounds = tree.nodes[leaf].bounds;
+
+    // Descend towards the cheapest sibling. Pairing with a node costs the
+    // new parent's area, plus the growth of every ancestor on the way down.
+    uint32_t sibling = tree.root;
+    while (!isAabbTreeLeaf(tree.nodes[sibling])) {
+        const AabbTreeNode& node = tree.nodes[sibling];
+        float area = getAABBHalfArea(node.bounds);
+        float combined_area = getAABBHalfArea(combineAABB(node.bounds, bounds));
+        float pair_cost = 2.0f * combined_area;
+        float inherited_cost = 2.0f * (combined_area - area);
+
+        float child_costs[2];
+        for (int i = 0; i < 2; ++i) {
+            const AabbTreeNode& child = tree.nodes[node.children[i]];
+            float child_area = getAABBHalfArea(combineAABB(child.bounds, bounds));
+            if (!isAabbTreeLeaf(child)) child_area -= getAABBHalfArea(child.bounds);
+            child_costs[i] = child_area + inherited_cost;
+        }
+        if (pair_cost < child_costs[0] && pair_cost < child_costs[1]) break;
+        sibling = node.children[child_costs[0] < child_costs[1] ? 0 : 1];
+    }
+
+    uint32_t parent = allocateAabbTreeNode(tree);
+    uint32_t old_parent = tree.nodes[sibling].parent;
+    replaceAabbTreeChild(tree, old_parent, sibling, parent);
+    tree.nodes[parent].parent = old_parent;
+    tree.nodes[parent].children[0] = sibling;
+    tree.nodes[parent].children[1] = leaf;
+    tree.nodes[sibling].parent = parent;
+    tree.nodes[leaf].parent = parent;
+    refitAabbTreeAncestors(tree, parent);
+    tree.nodes[leaf].reference_area = getAABBHalfArea(tree.nodes[tree.nodes[leaf].parent].bounds);
+}
+
+// Unlinks a leaf, leaving the node allocated
+void removeAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf) {
+    uint32_t parent = tree.nodes[leaf].parent;
+    if (parent == AABB_TREE_NULL_NODE) {
+        tree.root = AABB_TREE_NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the parent's place
+    const AabbTreeNode& parent_node = tree.nodes[parent];
+    uint32_t sibling = parent_node.children[parent_node.children[0] == leaf ? 1 : 0];
+    uint32_t grandparent = parent_node.parent;
+    replaceAabbTreeChild(tree, grandparent, parent, sibling);
+    tree.nodes[sibling].parent = grandparent;
+    freeAabbTreeNode(tree, parent);
+    refitAabbTreeAncestors(tree, grandparent);
+}
+
+uint32_t createAabbTreeLeaf(DynamicAabbTree& tree, const AABB& bounds, uint32_t item, float margin) {
+    uint32_t leaf = allocateAabbTreeNode(tree);
+    tree.nodes[leaf].bounds = growAABB(bounds, margin);
+    tree.nodes[leaf].item = item;
+    tree.nodes[leaf].height = 0;
+    ++tree.leaf_count;
+    insertAabbTreeLeaf(tree, leaf);
+    return leaf;
+}
+
+void destroyAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf) {
+    --tree.leaf_count;
+    removeAabbTreeLeaf(tree, leaf);
+    freeAabbTreeNode(tree, leaf);
+}
+
+void moveAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf, const AABB& bounds, float margin) {
+    if (containsAABB(tree.nodes[leaf].bounds, bounds)) {
+        ++tree.moves_absorbed;
+        return;
+    }
+    tree.nodes[leaf].bounds = growAABB(bounds, margin);
+
+    uint32_t parent = tree.nodes[leaf].parent;
+    if (parent != AABB_TREE_NULL_NODE) {
+        const AabbTreeNode& parent_node = tree.nodes[parent];
+        AABB refit = combineAABB(tree.nodes[parent_node.children[0]].bounds,
+                                 tree.nodes[parent_node.children[1]].bounds);
+        if (getAABBHalfArea(refit) > AABB_TREE_REINSERT_RATIO * tree.nodes[leaf].reference_area) {
+            // Moved away from its neighbours: find it new ones
+            ++tree.reinserts;
+            removeAabbTreeLeaf(tree, leaf);
+            insertAabbTreeLeaf(tree, leaf);
+            return;
+        }
+    }
+
+    // Refit bottom-up, stopping at the first ancestor the move didn't change.
+    // Heights don't change, so no rebalancing is needed.
+    ++tree.refits;
+    for (uint32_t index = parent; index != AABB_TREE_NULL_NODE; index = tree.nodes[index].parent) {
+        AABB old_bounds = tree.nodes[index].bounds;
+        updateAabbTreeNode(tree, index);
+        const AABB& new_bounds = tree.nodes[index].bounds;
+        if (new_bounds.min == old_bounds.min && new_bounds.max == old_bounds.max) break;
+    }
+}
+
+} // namespace Collision
@@ -0,0 +1,116 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include "Octree.h" // For AABB, CollisionRay, CollisionQueryStats
+#include <cstdint>
+#include <vector>
+
+namespace Collision {
+
+// Incremental binary AABB tree over a changing set of boxes (instances, not
+// triangles). Leaves are inserted next to the sibling that grows the tree's
+// surface area least and removed in O(log n); both rebalance the path to the
+// root with AVL rotations, so the height stays logarithmic whatever the
+// insertion order and no full rebuild is ever needed.
+// Node indices are stable while a leaf is alive; freed nodes are reused.
+// Moving leaves can keep a margin around their box so small moves cost
+// nothing; once a box escapes, its ancestors are refit in place, and the
+// leaf is only reinserted elsewhere when the refit has made its parent too
+// big (see AABB_TREE_REINSERT_RATIO).
+
+const uint32_t AABB_TREE_NULL_NODE = 0xFFFFFFFFu;
+// Traversal stack size; AVL balance keeps the height under 1.44 log2(n)
+const int AABB_TREE_STACK_SIZE = 64;
+// A moved leaf is refit in place while its parent's area stays within this
+// factor of the area it had when the leaf was (re)inserted
+const float AABB_TREE_REINSERT_RATIO = 2.0f;
+
+struct AabbTreeNode {
+    AABB bounds;
+    uint32_t parent = AABB_TREE_NULL_NODE; // Next free node while on the free list
+    uint32_t children[2] = {AABB_TREE_NULL_NODE, AABB_TREE_NULL_NODE}; // Null for leaves
+    uint32_t item = 0; // Leaves: the caller's id
+    int height = -1;   // 0 for leaves, -1 while free
+    float reference_area = 0.0f; // Leaves: parent's half area when (re)inserted
+};
+
+struct DynamicAabbTree {
+    std::vector<AabbTreeNode> nodes;
+    uint32_t root = AABB_TREE_NULL_NODE;
+    uint32_t free_list = AABB_TREE_NULL_NODE;
+    uint32_t leaf_count = 0;
+    // Outcome of every moveAabbTreeLeaf, for tuning margins
+    uint64_t moves_absorbed = 0; // Still inside the margin
+    uint64_t refits = 0;
+    uint64_t reinserts = 0;
+};
+
+inline bool isAabbTreeLeaf(const AabbTreeNode& node) {
+    return node.children[0] == AABB_TREE_NULL_NODE;
+}
+
+// Returns the leaf's node index, the handle for the other leaf calls. The
+// stored box is `bounds` grown by `margin` on every side.
+uint32_t createAabbTreeLeaf(DynamicAabbTree& tree, const AABB& bounds, uint32_t item, float margin = 0.0f);
+void destroyAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf);
+// O(1) while `bounds` stays inside the stored box, O(log n) otherwise. The
+// leaf keeps its handle.
+void moveAabbTreeLeaf(DynamicAabbTree& tree, uint32_t leaf, const AABB& bounds, float margin = 0.0f);
+
+// visitor(uint32_t item) -> bool, for every leaf overlapping query_bounds.
+// Returns false if the visitor stopped the query. No heap allocation.
+template <typename Visitor>
+bool visitAabbTree(const DynamicAabbTree& tree, const AABB& query_bounds, Visitor&& visitor,
+                   CollisionQueryStats* stats = nullptr) {
+    if (tree.root == AABB_TREE_NULL_NODE) return true;
+
+    uint32_t stack[AABB_TREE_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = tree.root;
+
+    while (stack_size > 0) {
+        const AabbTreeNode& node = tree.nodes[stack[--stack_size]];
+        if (stats) ++stats->nodes_visited;
+        if (!node.bounds.intersects(query_bounds)) continue;
+
+        if (isAabbTreeLeaf(node)) {
+            if (!visitor(node.item)) return false;
+        } else {
+            stack[stack_size++] = node.children[0];
+            stack[stack_size++] = node.children[1];
+        }
+    }
+    return true;
+}
+
+// visitor(uint32_t item, float& max_t) -> bool, for every leaf whose box
+// (grown by `expand`) the ray enters within [0, max_t]. Leaves come in no
+// particular order, but a visitor that lowers max_t prunes the rest.
+template <typename Visitor>
+bool visitAabbTreeRay(const DynamicAabbTree& tree, const CollisionRay& ray, float expand, float max_t,
+                      Visitor&& visitor, CollisionQueryStats* stats = nullptr) {
+    if (tree.root == AABB_TREE_NULL_NODE) return true;
+
+    uint32_t stack[AABB_TREE_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = tree.root;
+
+    while (stack_size > 0) {
+        const AabbTreeNode& node = tree.nodes[stack[--stack_size]];
+        if (stats) ++stats->nodes_visited;
+        float t_enter;
+        if (!intersectRayAABB(ray, node.bounds, expand, max_t, t_enter)) continue;
+
+        if (isAabbTreeLeaf(node)) {
+            if (!visitor(node.item, max_t)) return false;
+        } else {
+            stack[stack_size++] = node.children[0];
+            stack[stack_size++] = node.children[1];
+        }
+    }
+    return true;
+}
+
+} // namespace Collision
+
+#endif // AABB_TREE_H
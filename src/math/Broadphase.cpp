@@ -0,0 +1,148 @@
+#include "Broadphase.h"
+#include <algorithm>
+
+namespace Collision {
+
+// --- Helpers ---
+
+uint64_t makeBroadphasePairKey(uint32_t a, uint32_t b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+BroadphasePair getBroadphasePair(uint64_t key) {
+    return {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)};
+}
+
+bool isBroadphaseEndpointBefore(const BroadphaseEndpoint& a, const BroadphaseEndpoint& b) {
+    // Mins sort before maxes at equal values, so touching boxes overlap
+    // (matching AABB::intersects)
+    if (a.value != b.value) return a.value < b.value;
+    return (a.proxy_and_side & 1u) < (b.proxy_and_side & 1u);
+}
+
+float getBroadphaseEndpointValue(const Broadphase& broadphase, uint32_t proxy_and_side) {
+    const AABB& bounds = broadphase.proxies[proxy_and_side >> 1].bounds;
+    return (proxy_and_side & 1u) ? bounds.max.x : bounds.min.x;
+}
+
+// --- Broadphase Free Functions ---
+
+uint32_t createBroadphaseProxy(Broadphase& broadphase, const AABB& bounds) {
+    uint32_t proxy;
+    if (!broadphase.free_proxies.empty()) {
+        proxy = broadphase.free_proxies.back();
+        broadphase.free_proxies.pop_back();
+    } else {
+        proxy = static_cast<uint32_t>(broadphase.proxies.size());
+        broadphase.proxies.push_back(BroadphaseProxy());
+    }
+    broadphase.proxies[proxy].bounds = bounds;
+    broadphase.proxies[proxy].alive = true;
+
+    // Appended unsorted; the next update's insertion sort moves them into place
+    broadphase.endpoints.push_back({bounds.min.x, proxy << 1});
+    broadphase.endpoints.push_back({bounds.max.x, (proxy << 1) | 1u});
+    broadphase.added_endpoint_count += 2;
+    return proxy;
+}
+
+void destroyBroadphaseProxy(Broadphase& broadphase, uint32_t proxy) {
+    if (proxy >= broadphase.proxies.size() || !broadphase.proxies[proxy].alive) return;
+    broadphase.proxies[proxy].alive = false;
+    broadphase.destroyed_proxies.push_back(proxy);
+}
+
+void moveBroadphaseProxy(Broadphase& broadphase, uint32_t proxy, const AABB& bounds) {
+    broadphase.proxies[proxy].bounds = bounds;
+}
+
+void updateBroadphase(Broadphase& broadphase, BroadphasePairEvents& events) {
+    std::vector<BroadphaseEndpoint>& endpoints = broadphase.endpoints;
+
+    // Drop endpoints of destroyed proxies and refresh the rest
+    if (!broadphase.destroyed_proxies.empty()) {
+        endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+                                       [&](const BroadphaseEndpoint& endpoint) {
+                                           return !broadphase.proxies[endpoint.proxy_and_side >> 1].alive;
+                                       }),
+                        endpoints.end());
+    }
+    for (BroadphaseEndpoint& endpoint : endpoints) {
+        endpoint.value = getBroadphaseEndpointValue(broadphase, endpoint.proxy_and_side);
+    }
+
+    // Insertion sort: bodies move little per tick, so the order from the
+    // last update is nearly right and this is close to linear. Proxies added
+    // since then sit unsorted at the end; after a bulk add, a full sort is
+    // cheaper than inserting each one across the whole array.
+    if (broadphase.added_endpoint_count * 8 > endpoints.size()) {
+        std::sort(endpoints.begin(), endpoints.end(), isBroadphaseEndpointBefore);
+    } else {
+        for (size_t i = 1; i < endpoints.size(); ++i) {
+            BroadphaseEndpoint endpoint = endpoints[i];
+            size_t j = i;
+            for (; j > 0 && isBroadphaseEndpointBefore(endpoint, endpoints[j - 1]); --j) {
+                endpoints[j] = endpoints[j - 1];
+            }
+            endpoints[j] = endpoint;
+        }
+    }
+    broadphase.added_endpoint_count = 0;
+
+    // Sweep: every box opened while another is still open overlaps it on x
+    std::vector<uint64_t>& pairs = broadphase.next_pairs;
+    std::vector<BroadphaseActiveBox>& active = broadphase.active;
+    std::vector<uint32_t>& active_slots = broadphase.active_slots;
+    pairs.clear();
+    active.clear();
+    active_slots.resize(broadphase.proxies.size());
+    for (const BroadphaseEndpoint& endpoint : endpoints) {
+        uint32_t proxy = endpoint.proxy_and_side >> 1;
+        if (endpoint.proxy_and_side & 1u) {
+            // Swap-remove, keeping the moved box's slot up to date
+            uint32_t slot = active_slots[proxy];
+            active[slot] = active.back();
+            active_slots[active[slot].proxy] = slot;
+            active.pop_back();
+            continue;
+        }
+        const AABB& bounds = broadphase.proxies[proxy].bounds;
+        for (const BroadphaseActiveBox& other : active) {
+            // Non-short-circuit: the outcome is close to random, so branching
+            // per axis mispredicts
+            if ((bounds.min.y <= other.max_y) & (bounds.max.y >= other.min_y) &
+                (bounds.min.z <= other.max_z) & (bounds.max.z >= other.min_z)) {
+                pairs.push_back(makeBroadphasePairKey(proxy, other.proxy));
+            }
+        }
+        active_slots[proxy] = static_cast<uint32_t>(active.size());
+        active.push_back({proxy, bounds.min.y, bounds.max.y, bounds.min.z, bounds.max.z});
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    // Diff against the previous update (both lists sorted)
+    events.began.clear();
+    events.persisting.clear();
+    events.ended.clear();
+    const std::vector<uint64_t>& previous = broadphase.pairs;
+    size_t p = 0, n = 0;
+    while (p < previous.size() || n < pairs.size()) {
+        if (n == pairs.size() || (p < previous.size() && previous[p] < pairs[n])) {
+            events.ended.push_back(getBroadphasePair(previous[p++]));
+        } else if (p == previous.size() || pairs[n] < previous[p]) {
+            events.began.push_back(getBroadphasePair(pairs[n++]));
+        } else {
+            events.persisting.push_back(getBroadphasePair(pairs[n++]));
+            ++p;
+        }
+    }
+    broadphase.pairs.swap(pairs);
+
+    // Their ended pairs have now been reported, so the ids are safe to reuse
+    broadphase.free_proxies.insert(broadphase.free_proxies.end(), broadphase.destroyed_proxies.begin(),
+                                   broadphase.destroyed_proxies.end());
+    broadphase.destroyed_proxies.clear();
+}
+
+} // namespace Collision
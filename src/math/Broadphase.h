@@ -0,0 +1,70 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "Octree.h" // For AABB
+#include <cstdint>
+#include <vector>
+
+namespace Collision {
+
+// Sort-and-sweep broadphase for dynamic bodies. Box endpoints on the x axis
+// stay sorted between updates, so re-sorting after small moves is a
+// near-linear insertion sort; one sweep over the sorted endpoints then finds
+// every overlapping pair in O(n + pairs overlapping on x).
+// Proxies are handles; an id is only reused after the update that reported
+// the end of its pairs.
+
+const uint32_t BROADPHASE_NULL_PROXY = 0xFFFFFFFFu;
+
+struct BroadphaseProxy {
+    AABB bounds;
+    bool alive = false;
+};
+
+struct BroadphaseEndpoint {
+    float value;
+    uint32_t proxy_and_side; // proxy << 1 | 1 for a max endpoint
+};
+
+// Open box during the sweep; carries its y/z extent so the inner overlap
+// loop reads one contiguous array
+struct BroadphaseActiveBox {
+    uint32_t proxy;
+    float min_y, max_y, min_z, max_z;
+};
+
+struct BroadphasePair {
+    uint32_t a; // a < b
+    uint32_t b;
+};
+
+struct BroadphasePairEvents {
+    std::vector<BroadphasePair> began;      // Overlapping now, not last update
+    std::vector<BroadphasePair> persisting; // Overlapping both times
+    std::vector<BroadphasePair> ended;      // Overlapping last update, not now
+};
+
+struct Broadphase {
+    std::vector<BroadphaseProxy> proxies;
+    std::vector<uint32_t> free_proxies;
+    std::vector<uint32_t> destroyed_proxies; // Freed after the next update
+    std::vector<BroadphaseEndpoint> endpoints; // Sorted by value, mins first on ties
+    size_t added_endpoint_count = 0; // Appended since the last update
+    std::vector<uint64_t> pairs; // Pair keys from the last update, sorted
+    // Scratch reused between updates
+    std::vector<uint64_t> next_pairs;
+    std::vector<BroadphaseActiveBox> active; // Boxes open at the sweep position
+    std::vector<uint32_t> active_slots; // Per proxy, its index in `active`
+};
+
+uint32_t createBroadphaseProxy(Broadphase& broadphase, const AABB& bounds);
+void destroyBroadphaseProxy(Broadphase& broadphase, uint32_t proxy);
+// Cheap: only records the bounds; the work happens in updateBroadphase
+void moveBroadphaseProxy(Broadphase& broadphase, uint32_t proxy, const AABB& bounds);
+
+// Re-sorts, sweeps and diffs the overlapping pairs against the last update
+void updateBroadphase(Broadphase& broadphase, BroadphasePairEvents& events);
+
+} // namespace Collision
+
+#endif // BROADPHASE_H
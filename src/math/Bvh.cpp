@@ -0,0 +1,242 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <limits>
+
+namespace Collision {
+
+// --- Build Helpers ---
+
+const int BVH_SAH_BINS = 12;
+
+// Intermediate binary tree; collapsed into 4-wide nodes once built
+struct BvhBuildNode {
+    AABB bounds;
+    int left = -1;
+    int right = -1;
+    uint32_t first = 0; // Range into BvhBuildContext::indices (leaves only)
+    uint32_t count = 0;
+
+    bool isLeaf() const { return left < 0; }
+};
+
+struct BvhBuildContext {
+    std::vector<AABB> boxes;
+    std::vector<glm::vec3> centroids;
+    std::vector<uint32_t> indices;
+    std::vector<BvhBuildNode> nodes;
+    int max_leaf_triangles;
+};
+
+int buildBvhBinary(BvhBuildContext& ctx, uint32_t first, uint32_t count, int depth) {
+    AABB bounds = createEmptyAABB();
+    AABB centroid_bounds = createEmptyAABB();
+    for (uint32_t i = first; i < first + count; ++i) {
+        uint32_t tri = ctx.indices[i];
+        expandAABB(bounds, ctx.boxes[tri]);
+        expandAABB(centroid_bounds, AABB{ctx.centroids[tri], ctx.centroids[tri]});
+    }
+
+    int node_index = static_cast<int>(ctx.nodes.size());
+    ctx.nodes.push_back(BvhBuildNode());
+    ctx.nodes[node_index].bounds = bounds;
+    ctx.nodes[node_index].first = first;
+    ctx.nodes[node_index].count = count;
+
+    if (count <= static_cast<uint32_t>(ctx.max_leaf_triangles) || depth >= BVH_MAX_BUILD_DEPTH) {
+        return node_index;
+    }
+
+    // Split along the widest centroid axis
+    glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    uint32_t mid = first + count / 2;
+    if (extent[axis] > 0.0f) {
+        // Binned SAH
+        AABB bin_bounds[BVH_SAH_BINS];
+        uint32_t bin_counts[BVH_SAH_BINS] = {};
+        for (int b = 0; b < BVH_SAH_BINS; ++b) bin_bounds[b] = createEmptyAABB();
+
+        float scale = BVH_SAH_BINS / extent[axis];
+        auto getBin = [&](uint32_t tri) {
+            int bin = static_cast<int>((ctx.centroids[tri][axis] - centroid_bounds.min[axis]) * scale);
+            return std::min(bin, BVH_SAH_BINS - 1);
+        };
+        for (uint32_t i = first; i < first + count; ++i) {
+            int bin = getBin(ctx.indices[i]);
+            bin_counts[bin]++;
+            expandAABB(bin_bounds[bin], ctx.boxes[ctx.indices[i]]);
+        }
+
+        // Sweep from the right to get the cost of every right-hand side
+        float right_area[BVH_SAH_BINS];
+        uint32_t right_count[BVH_SAH_BINS];
+        AABB accumulated = createEmptyAABB();
+        uint32_t accumulated_count = 0;
+        for (int b = BVH_SAH_BINS - 1; b > 0; --b) {
+            expandAABB(accumulated, bin_bounds[b]);
+            accumulated_count += bin_counts[b];
+            right_area[b] = getAABBHalfArea(accumulated);
+            right_count[b] = accumulated_count;
+        }
+
+        float best_cost = std::numeric_limits<float>::max();
+        int best_split = -1;
+        accumulated = createEmptyAABB();
+        accumulated_count = 0;
+        for (int b = 1; b < BVH_SAH_BINS; ++b) {
+            expandAABB(accumulated, bin_bounds[b - 1]);
+            accumulated_count += bin_counts[b - 1];
+            if (accumulated_count == 0 || right_count[b] == 0) continue;
+            float cost = getAABBHalfArea(accumulated) * accumulated_count + right_area[b] * right_count[b];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = b;
+            }
+        }
+
+        if (best_split >= 0) {
+            // Stay a leaf if splitting doesn't pay off and the leaf is still small
+            float leaf_cost = getAABBHalfArea(bounds) * count;
+            if (best_cost >= leaf_cost && count <= 4u * ctx.max_leaf_triangles) {
+                return node_index;
+            }
+            auto split_it = std::partition(ctx.indices.begin() + first, ctx.indices.begin() + first + count,
+                                           [&](uint32_t tri) { return getBin(tri) < best_split; });
+            mid = static_cast<uint32_t>(split_it - ctx.indices.begin());
+        }
+    }
+
+    if (mid == first || mid == first + count) {
+        // Degenerate split (e.g. identical centroids): halve by position
+        mid = first + count / 2;
+        std::nth_element(ctx.indices.begin() + first, ctx.indices.begin() + mid, ctx.indices.begin() + first + count,
+                         [&](uint32_t a, uint32_t b) { return ctx.centroids[a][axis] < ctx.centroids[b][axis]; });
+    }
+
+    int left = buildBvhBinary(ctx, first, mid - first, depth + 1);
+    int right = buildBvhBinary(ctx, mid, first + count - mid, depth + 1);
+    ctx.nodes[node_index].left = left;
+    ctx.nodes[node_index].right = right;
+    return node_index;
+}
+
+void setBvh4Child(Bvh4Node& node, int slot, const AABB& bounds, uint32_t child, uint32_t triangle_count) {
+    node.min_x[slot] = bounds.min.x;
+    node.min_y[slot] = bounds.min.y;
+    node.min_z[slot] = bounds.min.z;
+    node.max_x[slot] = bounds.max.x;
+    node.max_y[slot] = bounds.max.y;
+    node.max_z[slot] = bounds.max.z;
+    node.child[slot] = child;
+    node.triangle_count[slot] = triangle_count;
+}
+
+Bvh4Node createEmptyBvh4Node() {
+    Bvh4Node node;
+    AABB empty = createEmptyAABB();
+    for (int i = 0; i < 4; ++i) {
+        setBvh4Child(node, i, empty, BVH_EMPTY_CHILD, 0);
+    }
+    return node;
+}
+
+// Collapses a binary subtree into a 4-wide node by repeatedly opening the
+// largest inner child until there are four children
+uint32_t emitBvh4Node(const BvhBuildContext& ctx, Bvh& bvh, int binary_index) {
+    const BvhBuildNode& binary = ctx.nodes[binary_index];
+    int children[4] = {binary.left, binary.right, -1, -1};
+    int child_count = 2;
+
+    while (child_count < 4) {
+        int best = -1;
+        float best_area = -1.0f;
+        for (int i = 0; i < child_count; ++i) {
+            const BvhBuildNode& candidate = ctx.nodes[children[i]];
+            if (!candidate.isLeaf() && getAABBHalfArea(candidate.bounds) > best_area) {
+                best_area = getAABBHalfArea(candidate.bounds);
+                best = i;
+            }
+        }
+        if (best < 0) break;
+
+        const BvhBuildNode& opened = ctx.nodes[children[best]];
+        children[best] = opened.left;
+        children[child_count++] = opened.right;
+    }
+
+    uint32_t node_index = static_cast<uint32_t>(bvh.nodes.size());
+    bvh.nodes.push_back(createEmptyBvh4Node());
+
+    for (int i = 0; i < child_count; ++i) {
+        const BvhBuildNode& child = ctx.nodes[children[i]];
+        if (child.isLeaf()) {
+            setBvh4Child(bvh.nodes[node_index], i, child.bounds, child.first, child.count);
+        } else {
+            uint32_t child_index = emitBvh4Node(ctx, bvh, children[i]);
+            // Re-index: the recursive call may have reallocated bvh.nodes
+            setBvh4Child(bvh.nodes[node_index], i, child.bounds, child_index, 0);
+        }
+    }
+    return node_index;
+}
+
+
+// --- BVH Free Functions ---
+
+Bvh buildBvh(const std::vector<Triangle>& triangles, int max_leaf_triangles) {
+    Bvh bvh;
+    bvh.bounds = createEmptyAABB();
+    if (triangles.empty()) return bvh;
+
+    BvhBuildContext ctx;
+    ctx.max_leaf_triangles = std::max(1, max_leaf_triangles);
+    ctx.boxes.reserve(triangles.size());
+    ctx.centroids.reserve(triangles.size());
+    ctx.indices.reserve(triangles.size());
+    for (uint32_t i = 0; i < triangles.size(); ++i) {
+        const Triangle& tri = triangles[i];
+        ctx.boxes.push_back(getTriangleAABB(tri));
+        ctx.centroids.push_back((tri.v0 + tri.v1 + tri.v2) / 3.0f);
+        ctx.indices.push_back(i);
+    }
+
+    int root = buildBvhBinary(ctx, 0, static_cast<uint32_t>(triangles.size()), 0);
+    const BvhBuildNode& root_node = ctx.nodes[root];
+    bvh.bounds = root_node.bounds;
+
+    if (root_node.isLeaf()) {
+        bvh.nodes.push_back(createEmptyBvh4Node());
+        setBvh4Child(bvh.nodes[0], 0, root_node.bounds, root_node.first, root_node.count);
+    } else {
+        emitBvh4Node(ctx, bvh, root);
+    }
+
+    // Leaves reference ranges of the build order, so store triangles in it
+    bvh.triangles.reserve(triangles.size());
+    for (uint32_t index : ctx.indices) {
+        bvh.triangles.push_back(triangles[index]);
+    }
+    return bvh;
+}
+
+BvhView getBvhView(const Bvh& bvh) {
+    BvhView view;
+    view.nodes = bvh.nodes.data();
+    view.node_count = static_cast<uint32_t>(bvh.nodes.size());
+    view.triangles = bvh.triangles.data();
+    view.triangle_count = static_cast<uint32_t>(bvh.triangles.size());
+    return view;
+}
+
+void getTrianglesFromBvh(const Bvh& bvh, const AABB& query_bounds, std::vector<Triangle>& out_triangles) {
+    visitBvhRanges(bvh, query_bounds, [&](uint32_t first, uint32_t count) {
+        out_triangles.insert(out_triangles.end(), bvh.triangles.begin() + first,
+                             bvh.triangles.begin() + first + count);
+        return true;
+    });
+}
+
+} // namespace Collision
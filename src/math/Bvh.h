@@ -0,0 +1,195 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "Octree.h" // For AABB, Triangle
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define BVH_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Collision {
+
+// Unused child slot marker
+const uint32_t BVH_EMPTY_CHILD = 0xFFFFFFFFu;
+
+// 4-wide BVH node. The four child boxes are stored SoA so one SIMD compare
+// per axis tests all of them against a query box.
+// For child i:
+//   triangle_count[i] > 0               -> leaf, triangles [child[i], child[i] + count)
+//   triangle_count[i] == 0, child valid -> inner node, index into Bvh::nodes
+//   child[i] == BVH_EMPTY_CHILD         -> unused slot (box is inverted, never hit)
+struct Bvh4Node {
+    alignas(16) float min_x[4];
+    alignas(16) float min_y[4];
+    alignas(16) float min_z[4];
+    alignas(16) float max_x[4];
+    alignas(16) float max_y[4];
+    alignas(16) float max_z[4];
+    uint32_t child[4];
+    uint32_t triangle_count[4];
+};
+
+// Traversal stack size; the build caps the tree depth so this cannot overflow
+const int BVH_STACK_SIZE = 256;
+const int BVH_MAX_BUILD_DEPTH = 64;
+
+struct Bvh {
+    std::vector<Bvh4Node> nodes;     // nodes[0] is the root (empty if no triangles)
+    std::vector<Triangle> triangles; // Reordered so every leaf is a contiguous range
+    AABB bounds;
+};
+
+// Non-owning view of a Bvh's arrays (see LinearOctreeView)
+struct BvhView {
+    const Bvh4Node* nodes = nullptr;
+    uint32_t node_count = 0;
+    const Triangle* triangles = nullptr;
+    uint32_t triangle_count = 0;
+};
+
+// Binned SAH build over triangle centroids, collapsed into 4-wide nodes
+Bvh buildBvh(const std::vector<Triangle>& triangles, int max_leaf_triangles = 4);
+BvhView getBvhView(const Bvh& bvh);
+
+// Bit i set if child i of the node overlaps the query box
+inline uint32_t intersectBvh4Children(const Bvh4Node& node, const AABB& query_bounds) {
+#ifdef BVH_SIMD_SSE
+    __m128 overlap = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_x), _mm_set1_ps(query_bounds.max.x)),
+                                _mm_cmpge_ps(_mm_load_ps(node.max_x), _mm_set1_ps(query_bounds.min.x)));
+    overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_y), _mm_set1_ps(query_bounds.max.y)),
+                                             _mm_cmpge_ps(_mm_load_ps(node.max_y), _mm_set1_ps(query_bounds.min.y))));
+    overlap = _mm_and_ps(overlap, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.min_z), _mm_set1_ps(query_bounds.max.z)),
+                                             _mm_cmpge_ps(_mm_load_ps(node.max_z), _mm_set1_ps(query_bounds.min.z))));
+    return static_cast<uint32_t>(_mm_movemask_ps(overlap));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (node.min_x[i] <= query_bounds.max.x && node.max_x[i] >= query_bounds.min.x &&
+            node.min_y[i] <= query_bounds.max.y && node.max_y[i] >= query_bounds.min.y &&
+            node.min_z[i] <= query_bounds.max.z && node.max_z[i] >= query_bounds.min.z) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// visitor(uint32_t first_triangle, uint32_t triangle_count) -> bool, called
+// for every leaf overlapping query_bounds. Same contract as the octree
+// visitors: return false to stop; returns false if stopped early. Each
+// 4-wide node counts as one visited node in `stats`.
+template <typename Visitor>
+bool visitBvhRanges(const BvhView& bvh, const AABB& query_bounds, Visitor&& visitor,
+                    CollisionQueryStats* stats = nullptr) {
+    if (bvh.node_count == 0) return true;
+
+    uint32_t stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const Bvh4Node& node = bvh.nodes[stack[--stack_size]];
+        uint32_t mask = intersectBvh4Children(node, query_bounds);
+        if (stats) ++stats->nodes_visited;
+
+        for (int i = 0; i < 4; ++i) {
+            if (!(mask & (1u << i))) continue;
+            if (node.triangle_count[i] > 0) {
+                if (stats) stats->triangles_returned += node.triangle_count[i];
+                if (!visitor(node.child[i], node.triangle_count[i])) return false;
+            } else {
+                stack[stack_size++] = node.child[i];
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool visitBvhRanges(const Bvh& bvh, const AABB& query_bounds, Visitor&& visitor,
+                    CollisionQueryStats* stats = nullptr) {
+    return visitBvhRanges(getBvhView(bvh), query_bounds, visitor, stats);
+}
+
+// visitor(uint32_t triangle_index) -> bool, index into bvh.triangles
+template <typename Visitor>
+bool visitBvhIndices(const BvhView& bvh, const AABB& query_bounds, Visitor&& visitor) {
+    return visitBvhRanges(bvh, query_bounds, [&](uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            if (!visitor(i)) return false;
+        }
+        return true;
+    });
+}
+
+template <typename Visitor>
+bool visitBvhIndices(const Bvh& bvh, const AABB& query_bounds, Visitor&& visitor) {
+    return visitBvhIndices(getBvhView(bvh), query_bounds, visitor);
+}
+
+// visitor(uint32_t first_triangle, uint32_t triangle_count, float& max_t) -> bool,
+// for every leaf whose box (grown by `expand`) the ray enters within
+// [0, max_t], nearest entry first. Same pruning contract as
+// visitLinearOctreeRay.
+template <typename Visitor>
+bool visitBvhRay(const BvhView& bvh, const CollisionRay& ray, float expand, float max_t, Visitor&& visitor,
+                 CollisionQueryStats* stats = nullptr) {
+    if (bvh.node_count == 0) return true;
+
+    // Leaves go through the stack too, so they are visited in entry order
+    struct Entry {
+        uint32_t index; // Node, or first triangle of a leaf
+        uint32_t triangle_count;
+        float t;
+    };
+    Entry stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = {0, 0, 0.0f};
+
+    while (stack_size > 0) {
+        Entry entry = stack[--stack_size];
+        if (entry.t > max_t) continue;
+        if (entry.triangle_count > 0) {
+            if (stats) stats->triangles_returned += entry.triangle_count;
+            if (!visitor(entry.index, entry.triangle_count, max_t)) return false;
+            continue;
+        }
+
+        const Bvh4Node& node = bvh.nodes[entry.index];
+        if (stats) ++stats->nodes_visited;
+        Entry children[4];
+        int child_hits = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (node.child[i] == BVH_EMPTY_CHILD) continue;
+            AABB box = {glm::vec3(node.min_x[i], node.min_y[i], node.min_z[i]),
+                        glm::vec3(node.max_x[i], node.max_y[i], node.max_z[i])};
+            float t;
+            if (!intersectRayAABB(ray, box, expand, max_t, t)) continue;
+            int j = child_hits++;
+            for (; j > 0 && children[j - 1].t < t; --j) {
+                children[j] = children[j - 1];
+            }
+            children[j] = {node.child[i], node.triangle_count[i], t};
+        }
+        for (int i = 0; i < child_hits; ++i) {
+            stack[stack_size++] = children[i];
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool visitBvhRay(const Bvh& bvh, const CollisionRay& ray, float expand, float max_t, Visitor&& visitor,
+                 CollisionQueryStats* stats = nullptr) {
+    return visitBvhRay(getBvhView(bvh), ray, expand, max_t, visitor, stats);
+}
+
+void getTrianglesFromBvh(const Bvh& bvh, const AABB& query_bounds, std::vector<Triangle>& out_triangles);
+
+} // namespace Collision
+
+#endif // BVH_H
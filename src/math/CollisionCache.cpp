@@ -0,0 +1,507 @@
+#include "CollisionCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Collision {
+
+// --- File Layout ---
+
+const char COLLISION_CACHE_MAGIC[8] = {'O', 'G', 'L', 'C', 'O', 'L', 'L', '\0'};
+const uint32_t COLLISION_CACHE_ENDIAN_MARKER = 0x01020304u;
+// Sections start on cache-line boundaries (mappings are page aligned), which
+// covers the 16-byte alignment of Bvh4Node
+const uint64_t COLLISION_CACHE_SECTION_ALIGNMENT = 64;
+
+struct CollisionCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_marker;
+    uint32_t node_size;     // sizeof(LinearOctreeNode) or sizeof(Bvh4Node)
+    uint32_t triangle_size; // sizeof(Triangle)
+    uint32_t backend;
+    uint32_t soa_stride;
+    uint64_t source_hash;
+    uint64_t node_count;
+    uint64_t triangle_count;
+    uint64_t nodes_offset;
+    uint64_t triangles_offset;
+    uint64_t soa_offset;
+    // Distance field; sdf_brick_count == 0 and no sections if none was baked
+    CollisionSdfGrid sdf_grid;
+    uint64_t sdf_brick_count;
+    uint64_t sdf_table_offset;
+    uint64_t sdf_samples_offset;
+    uint64_t sdf_exact_offset;
+    // Quantized triangles; if quantized_block_count > 0 they replace the
+    // triangle and SoA sections, which are then empty
+    uint64_t quantized_block_count;
+    uint64_t quantized_vertex_count;
+    uint64_t quantized_blocks_offset;
+    uint64_t quantized_vertices_offset;
+    uint64_t quantized_triangles_offset;
+    uint64_t file_size;
+};
+
+uint64_t alignCacheOffset(uint64_t offset) {
+    return (offset + COLLISION_CACHE_SECTION_ALIGNMENT - 1) & ~(COLLISION_CACHE_SECTION_ALIGNMENT - 1);
+}
+
+uint64_t getSoAFloatCount(uint32_t stride) {
+    return static_cast<uint64_t>(stride) * MathUtils::TRIANGLE_SOA_COMPONENTS;
+}
+
+// In 64 bits, so a corrupt grid can't wrap around to a small table
+uint64_t getSdfGridBrickCount(const CollisionSdfGrid& grid) {
+    return static_cast<uint64_t>(grid.brick_counts[0]) * grid.brick_counts[1] * grid.brick_counts[2];
+}
+
+uint64_t getSdfTableSize(const CollisionSdfGrid& grid) {
+    return getSdfGridBrickCount(grid) * sizeof(uint32_t);
+}
+
+uint32_t getCacheNodeSize(CollisionBackend backend) {
+    return backend == CollisionBackend::Bvh ? sizeof(Bvh4Node) : sizeof(LinearOctreeNode);
+}
+
+// --- Hashing ---
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+template <typename T>
+void hashValue(uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(T));
+}
+
+uint64_t hashCollisionSource(const std::vector<Triangle>& triangles, const CollisionWorldSettings& settings) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashValue(hash, static_cast<uint64_t>(triangles.size()));
+    hashBytes(hash, triangles.data(), triangles.size() * sizeof(Triangle));
+
+    // Field by field so struct padding never reaches the hash
+    hashValue(hash, COLLISION_CACHE_VERSION);
+    hashValue(hash, static_cast<uint32_t>(settings.backend));
+    hashValue(hash, settings.octree_auto_bounds);
+    hashValue(hash, settings.octree_bounds.min);
+    hashValue(hash, settings.octree_bounds.max);
+    hashValue(hash, settings.octree_max_depth);
+    hashValue(hash, settings.octree_triangles_per_node);
+    hashValue(hash, settings.octree_looseness);
+    hashValue(hash, settings.bvh_max_leaf_triangles);
+    hashValue(hash, settings.sdf_voxel_size);
+    hashValue(hash, settings.sdf_max_radius);
+    hashValue(hash, settings.quantize_triangles);
+    return hash;
+}
+
+std::string getCollisionCachePath(const std::string& directory, const std::string& asset_path) {
+    size_t slash = asset_path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? asset_path : asset_path.substr(slash + 1);
+    name = name.substr(0, name.find_last_of('.'));
+    if (directory.empty()) return name + ".collision";
+    return directory + '/' + name + ".collision";
+}
+
+// --- Mapping ---
+
+#ifdef _WIN32
+std::shared_ptr<const void> mapCacheFile(const std::string& path, uint64_t& size) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file); // The mapping keeps the file open
+    if (!mapping) return nullptr;
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) return nullptr;
+
+    size = static_cast<uint64_t>(file_size.QuadPart);
+    return std::shared_ptr<const void>(data, [](const void* p) { UnmapViewOfFile(p); });
+}
+#else
+std::shared_ptr<const void> mapCacheFile(const std::string& path, uint64_t& size) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) return nullptr;
+
+    size = static_cast<uint64_t>(st.st_size);
+    size_t length = static_cast<size_t>(st.st_size);
+    return std::shared_ptr<const void>(data, [length](const void* p) { munmap(const_cast<void*>(p), length); });
+}
+#endif
+
+bool isCacheSectionValid(uint64_t offset, uint64_t size, uint64_t file_size) {
+    return offset % COLLISION_CACHE_SECTION_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+// --- Validation ---
+// The section checks only keep each array inside the file. These follow
+// every index the queries do, so a file that is corrupt but the right size
+// can't send a traversal outside its arrays or overflow its stack.
+
+// Deepest trees the fixed traversal stacks hold
+const uint32_t CACHE_MAX_OCTREE_DEPTH = OCTREE_MAX_BUILD_DEPTH;
+const uint32_t CACHE_MAX_BVH_DEPTH = BVH_MAX_BUILD_DEPTH;
+
+bool isCacheRangeValid(uint64_t first, uint64_t count, uint64_t size) {
+    return first <= size && count <= size - first;
+}
+
+// Both builds put children after their parent, which rules out cycles and
+// settles every node's depth in one pass in index order
+bool isCachedOctreeValid(const LinearOctreeView& octree) {
+    std::vector<uint32_t> depths(octree.node_count, 0);
+    for (uint32_t i = 0; i < octree.node_count; ++i) {
+        const LinearOctreeNode& node = octree.nodes[i];
+        if (!isCacheRangeValid(node.first_triangle, node.triangle_count, octree.triangle_count)) return false;
+        if (node.child_count == 0) continue;
+        if (node.child_count > 8 || node.first_child <= i ||
+            !isCacheRangeValid(node.first_child, node.child_count, octree.node_count) ||
+            depths[i] >= CACHE_MAX_OCTREE_DEPTH) {
+            return false;
+        }
+        for (uint32_t c = 0; c < node.child_count; ++c) {
+            depths[node.first_child + c] = std::max(depths[node.first_child + c], depths[i] + 1);
+        }
+    }
+    return true;
+}
+
+bool isCachedBvhValid(const BvhView& bvh) {
+    std::vector<uint32_t> depths(bvh.node_count, 0);
+    for (uint32_t i = 0; i < bvh.node_count; ++i) {
+        const Bvh4Node& node = bvh.nodes[i];
+        for (int c = 0; c < 4; ++c) {
+            uint32_t child = node.child[c];
+            if (child == BVH_EMPTY_CHILD) {
+                // Only its inverted box keeps the box query from following it
+                if (node.triangle_count[c] != 0 || !(node.min_x[c] > node.max_x[c])) return false;
+            } else if (node.triangle_count[c] > 0) {
+                if (!isCacheRangeValid(child, node.triangle_count[c], bvh.triangle_count)) return false;
+            } else {
+                if (child <= i || child >= bvh.node_count || depths[i] >= CACHE_MAX_BVH_DEPTH) return false;
+                depths[child] = std::max(depths[child], depths[i] + 1);
+            }
+        }
+    }
+    return true;
+}
+
+// Blocks must start at triangle 0 and move forward through both the
+// triangles and the vertices; each triangle's indices stay inside the
+// vertices of its own block
+bool isCachedQuantizedValid(const QuantizedTrianglesView& quantized) {
+    if (quantized.blocks[0].first_triangle != 0) return false;
+    for (uint32_t b = 0; b < quantized.block_count; ++b) {
+        const QuantizedTriangleBlock& block = quantized.blocks[b];
+        bool last = b + 1 == quantized.block_count;
+        uint32_t end_triangle = last ? quantized.triangle_count : quantized.blocks[b + 1].first_triangle;
+        uint32_t end_vertex = last ? quantized.vertex_count : quantized.blocks[b + 1].first_vertex;
+        if (end_triangle <= block.first_triangle || end_vertex < block.first_vertex) return false;
+
+        uint32_t vertex_count = end_vertex - block.first_vertex;
+        for (uint32_t i = block.first_triangle; i < end_triangle; ++i) {
+            const QuantizedTriangle& triangle = quantized.triangles[i];
+            if (triangle.v[0] >= vertex_count || triangle.v[1] >= vertex_count || triangle.v[2] >= vertex_count) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The grid's cell and brick indices must fit the int and uint32_t math of
+// the lookup
+bool isCachedSdfGridValid(const CollisionSdfGrid& grid) {
+    for (int axis = 0; axis < 3; ++axis) {
+        if (grid.brick_counts[axis] > static_cast<uint32_t>(INT32_MAX / SDF_BRICK_CELLS)) return false;
+    }
+    return grid.voxel_size > 0.0f && getSdfGridBrickCount(grid) <= UINT32_MAX;
+}
+
+bool isCachedSdfValid(const CollisionSdfView& sdf) {
+    uint32_t table_size = getCollisionSdfGridBrickCount(sdf.grid);
+    for (uint32_t i = 0; i < table_size; ++i) {
+        if (sdf.brick_table[i] != SDF_EMPTY_BRICK && sdf.brick_table[i] >= sdf.brick_count) return false;
+    }
+    return true;
+}
+
+bool isCachedWorldValid(const CollisionWorld& world) {
+    if (world.backend == CollisionBackend::Bvh ? !isCachedBvhValid(world.bvh) : !isCachedOctreeValid(world.octree)) {
+        return false;
+    }
+    if (world.quantized.block_count > 0 && !isCachedQuantizedValid(world.quantized)) return false;
+    return world.sdf.brick_count == 0 || isCachedSdfValid(world.sdf);
+}
+
+bool loadCollisionCache(const std::string& cache_path, uint64_t source_hash, CollisionWorld& world) {
+    uint64_t file_size = 0;
+    std::shared_ptr<const void> mapping = mapCacheFile(cache_path, file_size);
+    if (!mapping || file_size < sizeof(CollisionCacheHeader)) return false;
+
+    const char* base = static_cast<const char*>(mapping.get());
+    CollisionCacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, COLLISION_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != COLLISION_CACHE_VERSION || header.endian_marker != COLLISION_CACHE_ENDIAN_MARKER ||
+        header.source_hash != source_hash || header.file_size != file_size) {
+        return false;
+    }
+    if (header.backend > static_cast<uint32_t>(CollisionBackend::Bvh)) return false;
+
+    CollisionBackend backend = static_cast<CollisionBackend>(header.backend);
+    bool quantized = header.quantized_block_count > 0;
+    if (header.node_size != getCacheNodeSize(backend) || header.triangle_size != sizeof(Triangle) ||
+        header.node_count > UINT32_MAX || header.triangle_count > UINT32_MAX ||
+        (!quantized && header.soa_stride < header.triangle_count) ||
+        header.quantized_block_count > UINT32_MAX || header.quantized_vertex_count > UINT32_MAX) {
+        return false;
+    }
+    uint64_t triangle_bytes = quantized ? 0 : header.triangle_count * header.triangle_size;
+    if (!isCacheSectionValid(header.nodes_offset, header.node_count * header.node_size, file_size) ||
+        !isCacheSectionValid(header.triangles_offset, triangle_bytes, file_size) ||
+        !isCacheSectionValid(header.soa_offset, getSoAFloatCount(header.soa_stride) * sizeof(float), file_size)) {
+        std::cout << "Collision cache " << cache_path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+    if (quantized &&
+        (!isCacheSectionValid(header.quantized_blocks_offset,
+                              header.quantized_block_count * sizeof(QuantizedTriangleBlock), file_size) ||
+         !isCacheSectionValid(header.quantized_vertices_offset,
+                              header.quantized_vertex_count * sizeof(QuantizedVertex), file_size) ||
+         !isCacheSectionValid(header.quantized_triangles_offset,
+                              header.triangle_count * sizeof(QuantizedTriangle), file_size))) {
+        std::cout << "Collision cache " << cache_path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+    bool has_sdf = header.sdf_brick_count > 0;
+    if (has_sdf &&
+        (header.sdf_brick_count > UINT32_MAX || !isCachedSdfGridValid(header.sdf_grid) ||
+         !isCacheSectionValid(header.sdf_table_offset, getSdfTableSize(header.sdf_grid), file_size) ||
+         !isCacheSectionValid(header.sdf_samples_offset,
+                              header.sdf_brick_count * SDF_BRICK_SAMPLE_COUNT * sizeof(float), file_size) ||
+         !isCacheSectionValid(header.sdf_exact_offset,
+                              header.sdf_brick_count * SDF_BRICK_EXACT_WORDS * sizeof(uint64_t), file_size))) {
+        std::cout << "Collision cache " << cache_path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    const Triangle* triangles =
+        quantized ? nullptr : reinterpret_cast<const Triangle*>(base + header.triangles_offset);
+    uint32_t node_count = static_cast<uint32_t>(header.node_count);
+    uint32_t triangle_count = static_cast<uint32_t>(header.triangle_count);
+
+    CollisionWorld loaded;
+    loaded.backend = backend;
+    if (backend == CollisionBackend::Bvh) {
+        loaded.bvh.nodes = reinterpret_cast<const Bvh4Node*>(base + header.nodes_offset);
+        loaded.bvh.node_count = node_count;
+        loaded.bvh.triangles = triangles;
+        loaded.bvh.triangle_count = triangle_count;
+    } else {
+        loaded.octree.nodes = reinterpret_cast<const LinearOctreeNode*>(base + header.nodes_offset);
+        loaded.octree.node_count = node_count;
+        loaded.octree.triangles = triangles;
+        loaded.octree.triangle_count = triangle_count;
+    }
+    if (quantized) {
+        loaded.quantized.blocks = reinterpret_cast<const QuantizedTriangleBlock*>(base + header.quantized_blocks_offset);
+        loaded.quantized.block_count = static_cast<uint32_t>(header.quantized_block_count);
+        loaded.quantized.vertices = reinterpret_cast<const QuantizedVertex*>(base + header.quantized_vertices_offset);
+        loaded.quantized.vertex_count = static_cast<uint32_t>(header.quantized_vertex_count);
+        loaded.quantized.triangles =
+            reinterpret_cast<const QuantizedTriangle*>(base + header.quantized_triangles_offset);
+        loaded.quantized.triangle_count = triangle_count;
+    } else {
+        loaded.triangle_soa.data = reinterpret_cast<const float*>(base + header.soa_offset);
+        loaded.triangle_soa.count = triangle_count;
+        loaded.triangle_soa.stride = header.soa_stride;
+    }
+    if (has_sdf) {
+        loaded.sdf.grid = header.sdf_grid;
+        loaded.sdf.brick_table = reinterpret_cast<const uint32_t*>(base + header.sdf_table_offset);
+        loaded.sdf.brick_count = static_cast<uint32_t>(header.sdf_brick_count);
+        loaded.sdf.samples = reinterpret_cast<const float*>(base + header.sdf_samples_offset);
+        loaded.sdf.exact_cells = reinterpret_cast<const uint64_t*>(base + header.sdf_exact_offset);
+    }
+    loaded.mapping = mapping;
+    if (!isCachedWorldValid(loaded)) {
+        std::cout << "Collision cache " << cache_path << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    world = std::move(loaded);
+    return true;
+}
+
+// --- Writing ---
+
+void writeCachePadding(std::ofstream& file, uint64_t& offset, uint64_t target) {
+    static const char zeros[COLLISION_CACHE_SECTION_ALIGNMENT] = {};
+    file.write(zeros, static_cast<std::streamsize>(target - offset));
+    offset = target;
+}
+
+bool writeCollisionCache(const std::string& cache_path, const CollisionWorld& world, uint64_t source_hash) {
+    const void* nodes;
+    uint64_t node_count;
+    if (world.backend == CollisionBackend::Bvh) {
+        nodes = world.bvh.nodes;
+        node_count = world.bvh.node_count;
+    } else {
+        nodes = world.octree.nodes;
+        node_count = world.octree.node_count;
+    }
+    const MathUtils::TriangleSoAView& soa = world.triangle_soa;
+
+    CollisionCacheHeader header = {};
+    std::memcpy(header.magic, COLLISION_CACHE_MAGIC, sizeof(header.magic));
+    header.version = COLLISION_CACHE_VERSION;
+    header.endian_marker = COLLISION_CACHE_ENDIAN_MARKER;
+    header.node_size = getCacheNodeSize(world.backend);
+    header.triangle_size = sizeof(Triangle);
+    header.backend = static_cast<uint32_t>(world.backend);
+    header.soa_stride = soa.stride;
+    header.source_hash = source_hash;
+    header.node_count = node_count;
+    header.triangle_count = getCollisionTriangleCount(world);
+
+    const QuantizedTrianglesView& quantized = world.quantized;
+    uint64_t node_bytes = node_count * header.node_size;
+    uint64_t triangle_bytes = quantized.block_count > 0 ? 0 : header.triangle_count * header.triangle_size;
+    uint64_t soa_bytes = getSoAFloatCount(soa.stride) * sizeof(float);
+    header.nodes_offset = alignCacheOffset(sizeof(CollisionCacheHeader));
+    header.triangles_offset = alignCacheOffset(header.nodes_offset + node_bytes);
+    header.soa_offset = alignCacheOffset(header.triangles_offset + triangle_bytes);
+    header.file_size = header.soa_offset + soa_bytes;
+
+    const CollisionSdfView& sdf = world.sdf;
+    uint64_t sdf_table_bytes = 0, sdf_sample_bytes = 0, sdf_exact_bytes = 0;
+    if (sdf.brick_count > 0) {
+        header.sdf_grid = sdf.grid;
+        header.sdf_brick_count = sdf.brick_count;
+        sdf_table_bytes = getSdfTableSize(sdf.grid);
+        sdf_sample_bytes = header.sdf_brick_count * SDF_BRICK_SAMPLE_COUNT * sizeof(float);
+        sdf_exact_bytes = header.sdf_brick_count * SDF_BRICK_EXACT_WORDS * sizeof(uint64_t);
+        header.sdf_table_offset = alignCacheOffset(header.file_size);
+        header.sdf_samples_offset = alignCacheOffset(header.sdf_table_offset + sdf_table_bytes);
+        header.sdf_exact_offset = alignCacheOffset(header.sdf_samples_offset + sdf_sample_bytes);
+        header.file_size = header.sdf_exact_offset + sdf_exact_bytes;
+    }
+
+    uint64_t quantized_block_bytes = 0, quantized_vertex_bytes = 0, quantized_triangle_bytes = 0;
+    if (quantized.block_count > 0) {
+        header.quantized_block_count = quantized.block_count;
+        header.quantized_vertex_count = quantized.vertex_count;
+        quantized_block_bytes = header.quantized_block_count * sizeof(QuantizedTriangleBlock);
+        quantized_vertex_bytes = header.quantized_vertex_count * sizeof(QuantizedVertex);
+        quantized_triangle_bytes = header.triangle_count * sizeof(QuantizedTriangle);
+        header.quantized_blocks_offset = alignCacheOffset(header.file_size);
+        header.quantized_vertices_offset = alignCacheOffset(header.quantized_blocks_offset + quantized_block_bytes);
+        header.quantized_triangles_offset =
+            alignCacheOffset(header.quantized_vertices_offset + quantized_vertex_bytes);
+        header.file_size = header.quantized_triangles_offset + quantized_triangle_bytes;
+    }
+
+    std::string temp_path = cache_path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << "Failed to write collision cache: " << temp_path << std::endl;
+            return false;
+        }
+        uint64_t offset = sizeof(CollisionCacheHeader);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeCachePadding(file, offset, header.nodes_offset);
+        file.write(static_cast<const char*>(nodes), static_cast<std::streamsize>(node_bytes));
+        offset += node_bytes;
+        writeCachePadding(file, offset, header.triangles_offset);
+        file.write(reinterpret_cast<const char*>(getCollisionTriangles(world)),
+                   static_cast<std::streamsize>(triangle_bytes));
+        offset += triangle_bytes;
+        writeCachePadding(file, offset, header.soa_offset);
+        file.write(reinterpret_cast<const char*>(soa.data), static_cast<std::streamsize>(soa_bytes));
+        offset += soa_bytes;
+        if (header.sdf_brick_count > 0) {
+            writeCachePadding(file, offset, header.sdf_table_offset);
+            file.write(reinterpret_cast<const char*>(sdf.brick_table), static_cast<std::streamsize>(sdf_table_bytes));
+            offset += sdf_table_bytes;
+            writeCachePadding(file, offset, header.sdf_samples_offset);
+            file.write(reinterpret_cast<const char*>(sdf.samples), static_cast<std::streamsize>(sdf_sample_bytes));
+            offset += sdf_sample_bytes;
+            writeCachePadding(file, offset, header.sdf_exact_offset);
+            file.write(reinterpret_cast<const char*>(sdf.exact_cells), static_cast<std::streamsize>(sdf_exact_bytes));
+            offset += sdf_exact_bytes;
+        }
+        if (header.quantized_block_count > 0) {
+            writeCachePadding(file, offset, header.quantized_blocks_offset);
+            file.write(reinterpret_cast<const char*>(quantized.blocks),
+                       static_cast<std::streamsize>(quantized_block_bytes));
+            offset += quantized_block_bytes;
+            writeCachePadding(file, offset, header.quantized_vertices_offset);
+            file.write(reinterpret_cast<const char*>(quantized.vertices),
+                       static_cast<std::streamsize>(quantized_vertex_bytes));
+            offset += quantized_vertex_bytes;
+            writeCachePadding(file, offset, header.quantized_triangles_offset);
+            file.write(reinterpret_cast<const char*>(quantized.triangles),
+                       static_cast<std::streamsize>(quantized_triangle_bytes));
+        }
+        if (!file) {
+            std::cout << "Failed to write collision cache: " << temp_path << std::endl;
+            file.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    std::remove(cache_path.c_str()); // rename() won't replace an existing file here
+#endif
+    if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+        std::cout << "Failed to replace collision cache: " << cache_path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace Collision
@@ -0,0 +1,42 @@
+#ifndef COLLISION_CACHE_H
+#define COLLISION_CACHE_H
+
+#include "CollisionWorld.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Collision {
+
+// Baked collision structure on disk. The file is the in-memory layout of the
+// built structure (nodes, packed triangles and SoA copy or their quantized
+// form, distance field if baked)
+// behind a small header, so loading is a single mmap: queries read the mapped
+// pages directly and processes loading the same file share them.
+// The format is native-endian and tied to the struct layouts; the header
+// records both, and any mismatch just makes the cache stale.
+const uint32_t COLLISION_CACHE_VERSION = 4;
+
+// FNV-1a over the triangles the structure is built from and every setting
+// that changes it. Keyed on the triangles rather than the asset file, so
+// geometry in a separate buffer (a .gltf's .bin) or a change in how the asset
+// is imported makes the cache stale too.
+uint64_t hashCollisionSource(const std::vector<Triangle>& triangles, const CollisionWorldSettings& settings);
+
+// Cache file for an asset: its file name with the extension swapped for
+// ".collision", in `directory` (empty for the working directory)
+std::string getCollisionCachePath(const std::string& directory, const std::string& asset_path);
+
+// Maps the cache into `world` if it exists and matches source_hash. Returns
+// false (leaving world untouched) if the file is missing, stale or invalid;
+// every index the queries follow is range checked here, once, so a corrupt
+// file is rejected rather than read out of bounds.
+bool loadCollisionCache(const std::string& cache_path, uint64_t source_hash, CollisionWorld& world);
+
+// Writes the active structure of `world`. The file is written next to the
+// target and renamed into place, so a reader never maps a partial file.
+bool writeCollisionCache(const std::string& cache_path, const CollisionWorld& world, uint64_t source_hash);
+
+} // namespace Collision
+
+#endif // COLLISION_CACHE_H
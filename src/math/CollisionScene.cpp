@@ -0,0 +1,243 @@
+#include "CollisionScene.h"
+#include <utility>
+
+namespace Collision {
+
+uint32_t addCollisionMesh(CollisionScene& scene, CollisionWorld&& world, const std::string& name) {
+    AABB bounds = createEmptyAABB();
+    visitCollisionRangeTriangles(world, 0, getCollisionTriangleCount(world), [&](uint32_t, const Triangle& triangle) {
+        expandAABB(bounds, getTriangleAABB(triangle));
+        return true;
+    });
+    scene.meshes.push_back(std::move(world));
+    scene.mesh_names.push_back(name);
+    scene.mesh_bounds.push_back(bounds);
+    return static_cast<uint32_t>(scene.meshes.size() - 1);
+}
+
+uint32_t findCollisionMesh(const CollisionScene& scene, const std::string& name) {
+    for (size_t i = 0; i < scene.mesh_names.size(); ++i) {
+        if (scene.mesh_names[i] == name) return static_cast<uint32_t>(i);
+    }
+    return COLLISION_NULL_MESH;
+}
+
+void setCollisionInstanceTransform(CollisionInstance& instance, const glm::mat4& transform) {
+    instance.transform = transform;
+    instance.inverse_transform = glm::inverse(transform);
+    instance.scale = glm::length(glm::vec3(transform[0]));
+}
+
+// Tight world box of an instance's mesh
+AABB getCollisionInstanceBounds(const CollisionScene& scene, const CollisionInstance& instance) {
+    return transformAABB(scene.mesh_bounds[instance.mesh], instance.transform);
+}
+
+void addCollisionSceneChange(CollisionScene& scene, const AABB& bounds) {
+    ++scene.revision;
+    if (scene.change_bounds.empty()) scene.change_bounds.resize(COLLISION_SCENE_CHANGE_LOG);
+    scene.change_bounds[scene.revision % COLLISION_SCENE_CHANGE_LOG] = bounds;
+}
+
+float getCollisionInstanceMargin(const CollisionInstance& instance) {
+    return instance.movable ? COLLISION_INSTANCE_MARGIN : 0.0f;
+}
+
+uint32_t createCollisionInstance(CollisionScene& scene, uint32_t mesh, const glm::mat4& transform, bool movable) {
+    uint32_t index;
+    if (!scene.free_instances.empty()) {
+        index = scene.free_instances.back();
+        scene.free_instances.pop_back();
+    } else {
+        index = static_cast<uint32_t>(scene.instances.size());
+        scene.instances.emplace_back();
+    }
+
+    CollisionInstance& instance = scene.instances[index];
+    instance.mesh = mesh;
+    instance.movable = movable;
+    setCollisionInstanceTransform(instance, transform);
+    AABB bounds = getCollisionInstanceBounds(scene, instance);
+    instance.tree_leaf = createAabbTreeLeaf(scene.tree, bounds, index, getCollisionInstanceMargin(instance));
+    addCollisionSceneChange(scene, bounds);
+    return index;
+}
+
+void destroyCollisionInstance(CollisionScene& scene, uint32_t instance) {
+    AABB bounds = getCollisionInstanceBounds(scene, scene.instances[instance]);
+    destroyAabbTreeLeaf(scene.tree, scene.instances[instance].tree_leaf);
+    scene.instances[instance] = CollisionInstance();
+    scene.free_instances.push_back(instance);
+    addCollisionSceneChange(scene, bounds);
+}
+
+void moveCollisionInstance(CollisionScene& scene, uint32_t instance, const glm::mat4& transform) {
+    CollisionInstance& moved = scene.instances[instance];
+    if (moved.transform == transform) return;
+    AABB bounds = getCollisionInstanceBounds(scene, moved);
+    setCollisionInstanceTransform(moved, transform);
+    AABB moved_bounds = getCollisionInstanceBounds(scene, moved);
+    moveAabbTreeLeaf(scene.tree, moved.tree_leaf, moved_bounds, getCollisionInstanceMargin(moved));
+    expandAABB(bounds, moved_bounds);
+    addCollisionSceneChange(scene, bounds);
+}
+
+uint32_t getCollisionInstanceCount(const CollisionScene& scene) {
+    return static_cast<uint32_t>(scene.instances.size() - scene.free_instances.size());
+}
+
+bool hasCollisionSceneChanged(const CollisionScene& scene, uint64_t revision, const AABB& bounds) {
+    if (revision == scene.revision) return false;
+    if (revision > scene.revision || scene.revision - revision > COLLISION_SCENE_CHANGE_LOG) return true;
+    for (uint64_t r = revision + 1; r <= scene.revision; ++r) {
+        if (scene.change_bounds[r % COLLISION_SCENE_CHANGE_LOG].intersects(bounds)) return true;
+    }
+    return false;
+}
+
+// --- Local Space ---
+// Identity transforms go through unchanged (x * 1 + y * 0 + ... is exact),
+// so a level placed at the origin answers exactly as a flat CollisionWorld.
+
+glm::vec3 toInstancePoint(const CollisionInstance& instance, const glm::vec3& point) {
+    return glm::vec3(instance.inverse_transform * glm::vec4(point, 1.0f));
+}
+
+glm::vec3 toInstanceVector(const CollisionInstance& instance, const glm::vec3& vector) {
+    return glm::mat3(instance.inverse_transform) * vector;
+}
+
+// Unit local normal to unit world normal
+glm::vec3 toWorldNormal(const CollisionInstance& instance, const glm::vec3& normal) {
+    return glm::mat3(instance.transform) * normal / instance.scale;
+}
+
+// Folds one scene query's counters into *stats. The per-instance queries it
+// fanned out to count as a single query, answered by the field only if all
+// of them were.
+void addSceneQueryStats(CollisionQueryStats* stats, CollisionQueryStats& query_stats) {
+    if (!stats) return;
+    query_stats.field_answers =
+        query_stats.queries > 0 && query_stats.field_answers == query_stats.queries ? 1 : 0;
+    query_stats.queries = 1;
+    addCollisionQueryStats(*stats, query_stats);
+}
+
+// --- Queries ---
+
+bool castCollisionRay(const CollisionScene& scene, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                      CollisionHit& hit, CollisionQueryStats* stats) {
+    CollisionQueryStats query_stats;
+    CollisionQueryStats* instance_stats = stats ? &query_stats : nullptr;
+    bool found = false;
+    visitAabbTreeRay(scene.tree, createCollisionRay(origin, direction), 0.0f, max_t,
+                     [&](uint32_t index, float& closest_t) {
+        const CollisionInstance& instance = scene.instances[index];
+        CollisionHit local;
+        // t is the same in both spaces, since the direction is transformed too
+        if (castCollisionRay(scene.meshes[instance.mesh], toInstancePoint(instance, origin),
+                             toInstanceVector(instance, direction), closest_t, local, instance_stats)) {
+            closest_t = local.t;
+            hit = local;
+            hit.normal = toWorldNormal(instance, local.normal);
+            hit.instance = index;
+            found = true;
+        }
+        return true;
+    }, instance_stats);
+    addSceneQueryStats(stats, query_stats);
+    return found;
+}
+
+bool isCollisionSegmentBlocked(const CollisionScene& scene, const glm::vec3& from, const glm::vec3& to,
+                               CollisionQueryStats* stats) {
+    CollisionQueryStats query_stats;
+    CollisionQueryStats* instance_stats = stats ? &query_stats : nullptr;
+    bool blocked = !visitAabbTreeRay(scene.tree, createCollisionRay(from, to - from), 0.0f, 1.0f,
+                                     [&](uint32_t index, float&) {
+        const CollisionInstance& instance = scene.instances[index];
+        return !isCollisionSegmentBlocked(scene.meshes[instance.mesh], toInstancePoint(instance, from),
+                                          toInstancePoint(instance, to), instance_stats);
+    }, instance_stats);
+    addSceneQueryStats(stats, query_stats);
+    return blocked;
+}
+
+bool castCollisionSphere(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                         const glm::vec3& motion, CollisionHit& hit, CollisionQueryStats* stats, CastFilter filter) {
+    CollisionQueryStats query_stats;
+    CollisionQueryStats* instance_stats = stats ? &query_stats : nullptr;
+    bool found = false;
+    visitAabbTreeRay(scene.tree, createCollisionRay(sphere_center, motion), sphere_radius, 1.0f,
+                     [&](uint32_t index, float& closest_t) {
+        const CollisionInstance& instance = scene.instances[index];
+        // The mesh cast only covers the motion up to the best hit so far,
+        // so its t in [0, 1] is a fraction of closest_t. Rigid transforms
+        // keep angles, so the filter sees the same cosines locally.
+        CollisionHit local;
+        if (castCollisionSphere(scene.meshes[instance.mesh], toInstancePoint(instance, sphere_center),
+                                sphere_radius / instance.scale, toInstanceVector(instance, motion * closest_t),
+                                local, instance_stats, filter)) {
+            closest_t *= local.t;
+            hit = local;
+            hit.t = closest_t;
+            hit.normal = toWorldNormal(instance, local.normal);
+            hit.instance = index;
+            found = true;
+        }
+        // Nothing can come before an initial overlap
+        return !(found && closest_t == 0.0f);
+    }, instance_stats);
+    addSceneQueryStats(stats, query_stats);
+    return found;
+}
+
+// Deepest contact over the instances near the sphere, with contact_query
+// running the CollisionWorld query in an instance's local space
+template <typename ContactQuery>
+bool findSceneSphereContact(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                            glm::vec3& collision_normal, float& penetration_depth, CollisionQueryStats* stats,
+                            ContactQuery&& contact_query) {
+    // Padded like the CollisionWorld query box
+    AABB query = {sphere_center - glm::vec3(sphere_radius + 0.1f), sphere_center + glm::vec3(sphere_radius + 0.1f)};
+
+    CollisionQueryStats query_stats;
+    CollisionQueryStats* instance_stats = stats ? &query_stats : nullptr;
+    penetration_depth = 0.0f;
+    bool hit = false;
+    visitAabbTree(scene.tree, query, [&](uint32_t index) {
+        const CollisionInstance& instance = scene.instances[index];
+        glm::vec3 normal(0.0f);
+        float depth = 0.0f;
+        if (contact_query(scene.meshes[instance.mesh], toInstancePoint(instance, sphere_center),
+                          sphere_radius / instance.scale, normal, depth, instance_stats) &&
+            depth * instance.scale > penetration_depth) {
+            penetration_depth = depth * instance.scale;
+            collision_normal = toWorldNormal(instance, normal);
+            hit = true;
+        }
+        return true;
+    }, instance_stats);
+    addSceneQueryStats(stats, query_stats);
+    return hit;
+}
+
+bool findDeepestSphereContact(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& penetration_depth, CollisionQueryStats* stats) {
+    return findSceneSphereContact(scene, sphere_center, sphere_radius, collision_normal, penetration_depth, stats,
+                                  [](const CollisionWorld& world, const glm::vec3& center, float radius,
+                                     glm::vec3& normal, float& depth, CollisionQueryStats* instance_stats) {
+        return findDeepestSphereContact(world, center, radius, normal, depth, instance_stats);
+    });
+}
+
+bool findApproximateSphereContact(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                                  glm::vec3& collision_normal, float& penetration_depth, CollisionQueryStats* stats) {
+    return findSceneSphereContact(scene, sphere_center, sphere_radius, collision_normal, penetration_depth, stats,
+                                  [](const CollisionWorld& world, const glm::vec3& center, float radius,
+                                     glm::vec3& normal, float& depth, CollisionQueryStats* instance_stats) {
+        return findApproximateSphereContact(world, center, radius, normal, depth, instance_stats);
+    });
+}
+
+} // namespace Collision
@@ -0,0 +1,102 @@
+#ifndef COLLISION_SCENE_H
+#define COLLISION_SCENE_H
+
+#include "AabbTree.h"
+#include "CollisionWorld.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Collision {
+
+// Two-level static collision. Each unique mesh gets one CollisionWorld,
+// built in the mesh's own (model) space; instances place meshes in the world
+// with a transform. A DynamicAabbTree over the instances' world boxes finds
+// the instances a query touches, and the query is moved into each one's
+// local space and run against its mesh. A repeated prop costs an instance,
+// not another copy of its triangles, and adding or removing a static object
+// only touches the top-level tree.
+// Instance transforms must be rigid with uniform scale, so that a sphere
+// stays a sphere in local space.
+// Moving geometry (platforms, doors) is a movable instance: a move only
+// replaces its transform and updates its top-level leaf (see
+// moveAabbTreeLeaf), so it costs the same whatever the mesh's size, and the
+// mesh's own structure is never touched.
+
+const uint32_t COLLISION_NULL_MESH = 0xFFFFFFFFu;
+const uint32_t COLLISION_NULL_INSTANCE = 0xFFFFFFFFu;
+// Padding around a movable instance's box in the top-level tree (world
+// units); moves that stay within it leave the tree alone
+const float COLLISION_INSTANCE_MARGIN = 0.25f;
+// Scene changes remembered with their bounds (see CollisionScene::change_bounds).
+// Something that last looked at the scene more changes ago than this has to
+// assume all of it changed.
+const uint32_t COLLISION_SCENE_CHANGE_LOG = 256;
+
+struct CollisionInstance {
+    uint32_t mesh = COLLISION_NULL_MESH; // Index into CollisionScene::meshes; null while free
+    glm::mat4 transform{1.0f};           // Local to world
+    glm::mat4 inverse_transform{1.0f};
+    float scale = 1.0f;                  // Of `transform`; local lengths * scale = world lengths
+    bool movable = false;
+    uint32_t tree_leaf = AABB_TREE_NULL_NODE;
+};
+
+struct CollisionScene {
+    std::vector<CollisionWorld> meshes;
+    std::vector<std::string> mesh_names; // Per mesh, the key it is shared under
+    std::vector<AABB> mesh_bounds;       // Per mesh, local space
+    std::vector<CollisionInstance> instances;
+    std::vector<uint32_t> free_instances;
+    DynamicAabbTree tree; // Leaf items are instance indices
+    // Bumped whenever an instance is created, destroyed or actually moved.
+    // The world box each of the latest changes touched (the instance's box
+    // before and after it) is kept at change_bounds[revision %
+    // COLLISION_SCENE_CHANGE_LOG], so anything cached from part of the scene
+    // (see ContactCache.h) only goes stale when a change reaches that part.
+    uint64_t revision = 0;
+    std::vector<AABB> change_bounds;
+};
+
+// Takes a built or cache-loaded world; returns its mesh index
+uint32_t addCollisionMesh(CollisionScene& scene, CollisionWorld&& world, const std::string& name);
+// COLLISION_NULL_MESH if no mesh was added under `name`
+uint32_t findCollisionMesh(const CollisionScene& scene, const std::string& name);
+
+uint32_t createCollisionInstance(CollisionScene& scene, uint32_t mesh, const glm::mat4& transform,
+                                 bool movable = false);
+void destroyCollisionInstance(CollisionScene& scene, uint32_t instance);
+// Any instance can move; movable ones keep a margin so most moves are O(1).
+// Moving to the current transform is free and leaves the revision alone.
+void moveCollisionInstance(CollisionScene& scene, uint32_t instance, const glm::mat4& transform);
+uint32_t getCollisionInstanceCount(const CollisionScene& scene);
+// Whether anything inside `bounds` may have changed since the scene was at
+// `revision`: a change since then touched them, or there were too many
+// changes to tell
+bool hasCollisionSceneChanged(const CollisionScene& scene, uint64_t revision, const AABB& bounds);
+
+// The CollisionWorld queries, across every instance. Results are in world
+// space; CollisionHit::instance says which instance was hit, and
+// CollisionHit::triangle indexes that instance's mesh. Stats count each
+// scene query once, with the top-level tree's nodes and the work of every
+// instance it reached.
+
+bool castCollisionRay(const CollisionScene& scene, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                      CollisionHit& hit, CollisionQueryStats* stats = nullptr);
+bool isCollisionSegmentBlocked(const CollisionScene& scene, const glm::vec3& from, const glm::vec3& to,
+                               CollisionQueryStats* stats = nullptr);
+bool castCollisionSphere(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                         const glm::vec3& motion, CollisionHit& hit, CollisionQueryStats* stats = nullptr,
+                         CastFilter filter = CastFilter::All);
+bool findDeepestSphereContact(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& penetration_depth,
+                              CollisionQueryStats* stats = nullptr);
+// Counts as answered by the field only if every instance it reached was
+bool findApproximateSphereContact(const CollisionScene& scene, const glm::vec3& sphere_center, float sphere_radius,
+                                  glm::vec3& collision_normal, float& penetration_depth,
+                                  CollisionQueryStats* stats = nullptr);
+
+} // namespace Collision
+
+#endif // COLLISION_SCENE_H
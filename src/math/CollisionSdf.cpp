@@ -0,0 +1,254 @@
+#include "CollisionSdf.h"
+#include "CollisionWorld.h"
+#include "GeometryUtils.h"
+#include "../utils/WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Collision {
+
+// Corners whose closest-point directions differ by more than this (cosine)
+// see different surfaces, so the cell is left to the triangles
+const float SDF_CELL_DIRECTION_AGREEMENT = 0.9f;
+
+// --- Helpers ---
+
+uint32_t getCollisionSdfGridBrickCount(const CollisionSdfGrid& grid) {
+    return grid.brick_counts[0] * grid.brick_counts[1] * grid.brick_counts[2];
+}
+
+int getSdfSampleIndex(int x, int y, int z) {
+    return (z * SDF_BRICK_SAMPLES + y) * SDF_BRICK_SAMPLES + x;
+}
+
+int getSdfCellIndex(int x, int y, int z) {
+    return (z * SDF_BRICK_CELLS + y) * SDF_BRICK_CELLS + x;
+}
+
+float getPointAABBDistanceSquared(const glm::vec3& point, const AABB& box) {
+    glm::vec3 outside = glm::max(box.min - point, glm::max(point - box.max, glm::vec3(0.0f)));
+    return glm::dot(outside, outside);
+}
+
+AABB getSdfBrickBounds(const CollisionSdfGrid& grid, uint32_t x, uint32_t y, uint32_t z) {
+    float brick_size = grid.voxel_size * SDF_BRICK_CELLS;
+    glm::vec3 min = grid.origin + glm::vec3(x, y, z) * brick_size;
+    return {min, min + glm::vec3(brick_size)};
+}
+
+// Triangles of the world that come within `band` of the box
+void collectSdfCandidates(const CollisionWorld& world, const AABB& box, float band,
+                          std::vector<MathUtils::TriangleRecord>& candidates) {
+    AABB query = {box.min - glm::vec3(band), box.max + glm::vec3(band)};
+    candidates.clear();
+    visitCollisionTriangles(world, query, [&](uint32_t index, const Triangle&) {
+        MathUtils::TriangleRecord record = MathUtils::getSoATriangleRecord(world.triangle_soa, index);
+        if (record.bounds.intersects(query)) candidates.push_back(record);
+        return true;
+    });
+}
+
+void bakeSdfBrick(const CollisionSdfGrid& grid, const AABB& brick_bounds,
+                  const std::vector<MathUtils::TriangleRecord>& candidates, float* samples, uint64_t* exact_cells) {
+    // Closest-point direction per sample; zero where nothing is in the band
+    // or the sample sits on a triangle
+    glm::vec3 directions[SDF_BRICK_SAMPLE_COUNT];
+    const float band_sq = grid.band * grid.band;
+    const size_t candidate_count = candidates.size();
+    size_t last_best = 0; // Neighbouring samples mostly share a closest triangle
+
+    for (int z = 0; z < SDF_BRICK_SAMPLES; ++z) {
+        for (int y = 0; y < SDF_BRICK_SAMPLES; ++y) {
+            for (int x = 0; x < SDF_BRICK_SAMPLES; ++x) {
+                glm::vec3 point = brick_bounds.min + glm::vec3(x, y, z) * grid.voxel_size;
+                float best_sq = band_sq;
+                glm::vec3 best_offset(0.0f);
+                // Starting from the last sample's winner tightens best_sq
+                // at once, so the bounds test rejects most of the rest
+                for (size_t n = 0; n < candidate_count; ++n) {
+                    size_t c = n == 0 ? last_best : (n == last_best ? 0 : n);
+                    const MathUtils::TriangleRecord& record = candidates[c];
+                    if (getPointAABBDistanceSquared(point, record.bounds) >= best_sq) continue;
+                    glm::vec3 offset = point - MathUtils::closestPointOnTriangleRecord(point, record);
+                    float distance_sq = glm::dot(offset, offset);
+                    if (distance_sq < best_sq) { // False for NaN (degenerate triangles)
+                        best_sq = distance_sq;
+                        best_offset = offset;
+                        last_best = c;
+                    }
+                }
+                int index = getSdfSampleIndex(x, y, z);
+                samples[index] = std::sqrt(best_sq);
+                directions[index] = best_sq > 0.0f && best_sq < band_sq ? best_offset / samples[index]
+                                                                         : glm::vec3(0.0f);
+            }
+        }
+    }
+
+    std::fill(exact_cells, exact_cells + SDF_BRICK_EXACT_WORDS, 0ull);
+    for (int z = 0; z < SDF_BRICK_CELLS; ++z) {
+        for (int y = 0; y < SDF_BRICK_CELLS; ++y) {
+            for (int x = 0; x < SDF_BRICK_CELLS; ++x) {
+                // Compare the corners that saw a surface; a corner on a
+                // triangle has no direction and always flags the cell
+                glm::vec3 corners[8];
+                int corner_count = 0;
+                bool exact = false;
+                for (int c = 0; c < 8 && !exact; ++c) {
+                    int index = getSdfSampleIndex(x + (c & 1), y + ((c >> 1) & 1), z + (c >> 2));
+                    if (samples[index] >= grid.band) continue;
+                    if (directions[index] == glm::vec3(0.0f)) {
+                        exact = true;
+                        break;
+                    }
+                    for (int other = 0; other < corner_count; ++other) {
+                        if (glm::dot(corners[other], directions[index]) < SDF_CELL_DIRECTION_AGREEMENT) {
+                            exact = true;
+                            break;
+                        }
+                    }
+                    corners[corner_count++] = directions[index];
+                }
+                if (exact) {
+                    int cell = getSdfCellIndex(x, y, z);
+                    exact_cells[cell >> 6] |= 1ull << (cell & 63);
+                }
+            }
+        }
+    }
+}
+
+// --- Baking ---
+
+CollisionSdf bakeCollisionSdf(const CollisionWorld& world, float voxel_size, float max_radius, int thread_count) {
+    CollisionSdf sdf;
+    const Triangle* triangles = getCollisionTriangles(world);
+    uint32_t triangle_count = getCollisionTriangleCount(world);
+    if (triangle_count == 0 || voxel_size <= 0.0f) return sdf;
+
+    // Interpolation is off by up to about a voxel diagonal, so the band
+    // reaches past max_radius by that much; clamped samples then never
+    // produce a contact
+    CollisionSdfGrid& grid = sdf.grid;
+    grid.voxel_size = voxel_size;
+    grid.band = max_radius + voxel_size * 2.0f;
+
+    AABB bounds = createEmptyAABB();
+    for (uint32_t i = 0; i < triangle_count; ++i) {
+        expandAABB(bounds, getTriangleAABB(triangles[i]));
+    }
+    grid.origin = bounds.min - glm::vec3(grid.band);
+    glm::vec3 extent = bounds.max - bounds.min + glm::vec3(2.0f * grid.band);
+    float brick_size = voxel_size * SDF_BRICK_CELLS;
+    for (int axis = 0; axis < 3; ++axis) {
+        grid.brick_counts[axis] = std::max(1u, static_cast<uint32_t>(std::ceil(extent[axis] / brick_size)));
+    }
+
+    // Keep only bricks with a triangle in reach
+    sdf.brick_table.assign(getCollisionSdfGridBrickCount(grid), SDF_EMPTY_BRICK);
+    std::vector<uint32_t> stored_bricks; // Grid index of each stored brick
+    for (uint32_t z = 0; z < grid.brick_counts[2]; ++z) {
+        for (uint32_t y = 0; y < grid.brick_counts[1]; ++y) {
+            for (uint32_t x = 0; x < grid.brick_counts[0]; ++x) {
+                AABB box = getSdfBrickBounds(grid, x, y, z);
+                AABB query = {box.min - glm::vec3(grid.band), box.max + glm::vec3(grid.band)};
+                bool near = !visitCollisionTriangles(world, query, [&](uint32_t, const Triangle& triangle) {
+                    return !getTriangleAABB(triangle).intersects(query);
+                });
+                if (!near) continue;
+                uint32_t grid_index = (z * grid.brick_counts[1] + y) * grid.brick_counts[0] + x;
+                sdf.brick_table[grid_index] = static_cast<uint32_t>(stored_bricks.size());
+                stored_bricks.push_back(grid_index);
+            }
+        }
+    }
+
+    sdf.samples.resize(stored_bricks.size() * SDF_BRICK_SAMPLE_COUNT);
+    sdf.exact_cells.resize(stored_bricks.size() * SDF_BRICK_EXACT_WORDS);
+    std::unique_ptr<WorkerPool> pool = createWorkerPool(thread_count);
+    parallelFor(*pool, stored_bricks.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<MathUtils::TriangleRecord> candidates;
+        for (size_t brick = begin; brick < end; ++brick) {
+            uint32_t grid_index = stored_bricks[brick];
+            uint32_t x = grid_index % grid.brick_counts[0];
+            uint32_t y = (grid_index / grid.brick_counts[0]) % grid.brick_counts[1];
+            uint32_t z = grid_index / (grid.brick_counts[0] * grid.brick_counts[1]);
+            AABB box = getSdfBrickBounds(grid, x, y, z);
+            collectSdfCandidates(world, box, grid.band, candidates);
+            bakeSdfBrick(grid, box, candidates, &sdf.samples[brick * SDF_BRICK_SAMPLE_COUNT],
+                         &sdf.exact_cells[brick * SDF_BRICK_EXACT_WORDS]);
+        }
+    });
+    return sdf;
+}
+
+CollisionSdfView getCollisionSdfView(const CollisionSdf& sdf) {
+    CollisionSdfView view;
+    view.grid = sdf.grid;
+    view.brick_table = sdf.brick_table.data();
+    view.brick_count = static_cast<uint32_t>(sdf.samples.size() / SDF_BRICK_SAMPLE_COUNT);
+    view.samples = sdf.samples.data();
+    view.exact_cells = sdf.exact_cells.data();
+    return view;
+}
+
+// --- Queries ---
+
+SdfContactResult sampleSdfSphereContact(const CollisionSdfView& sdf, const glm::vec3& sphere_center,
+                                        float sphere_radius, glm::vec3& collision_normal,
+                                        float& penetration_depth) {
+    const CollisionSdfGrid& grid = sdf.grid;
+    if (!sdf.brick_table || sphere_radius > grid.band - grid.voxel_size * 2.0f) return SdfContactResult::Exact;
+
+    // Outside the grid (or in a dropped brick) every triangle is beyond the band
+    glm::vec3 local = (sphere_center - grid.origin) / grid.voxel_size;
+    int cell[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        float limit = static_cast<float>(grid.brick_counts[axis] * SDF_BRICK_CELLS);
+        if (!(local[axis] >= 0.0f && local[axis] < limit)) return SdfContactResult::Miss;
+        cell[axis] = std::min(static_cast<int>(local[axis]), static_cast<int>(limit) - 1);
+    }
+    uint32_t grid_index = ((cell[2] / SDF_BRICK_CELLS) * grid.brick_counts[1] + cell[1] / SDF_BRICK_CELLS) *
+                              grid.brick_counts[0] + cell[0] / SDF_BRICK_CELLS;
+    uint32_t brick = sdf.brick_table[grid_index];
+    if (brick == SDF_EMPTY_BRICK) return SdfContactResult::Miss;
+
+    int x = cell[0] % SDF_BRICK_CELLS, y = cell[1] % SDF_BRICK_CELLS, z = cell[2] % SDF_BRICK_CELLS;
+    int cell_index = getSdfCellIndex(x, y, z);
+    if (sdf.exact_cells[brick * SDF_BRICK_EXACT_WORDS + (cell_index >> 6)] & (1ull << (cell_index & 63))) {
+        return SdfContactResult::Exact;
+    }
+
+    const float* samples = sdf.samples + static_cast<size_t>(brick) * SDF_BRICK_SAMPLE_COUNT;
+    float c000 = samples[getSdfSampleIndex(x, y, z)];
+    float c100 = samples[getSdfSampleIndex(x + 1, y, z)];
+    float c010 = samples[getSdfSampleIndex(x, y + 1, z)];
+    float c110 = samples[getSdfSampleIndex(x + 1, y + 1, z)];
+    float c001 = samples[getSdfSampleIndex(x, y, z + 1)];
+    float c101 = samples[getSdfSampleIndex(x + 1, y, z + 1)];
+    float c011 = samples[getSdfSampleIndex(x, y + 1, z + 1)];
+    float c111 = samples[getSdfSampleIndex(x + 1, y + 1, z + 1)];
+    float fx = local.x - cell[0], fy = local.y - cell[1], fz = local.z - cell[2];
+
+    // Trilinear distance and its analytic gradient
+    float c00 = c000 + (c100 - c000) * fx, c10 = c010 + (c110 - c010) * fx;
+    float c01 = c001 + (c101 - c001) * fx, c11 = c011 + (c111 - c011) * fx;
+    float c0 = c00 + (c10 - c00) * fy, c1 = c01 + (c11 - c01) * fy;
+    float distance = c0 + (c1 - c0) * fz;
+    if (distance >= sphere_radius) return SdfContactResult::Miss;
+    if (distance < grid.voxel_size) return SdfContactResult::Exact;
+
+    glm::vec3 gradient;
+    gradient.x = ((c100 - c000) * (1.0f - fy) + (c110 - c010) * fy) * (1.0f - fz) +
+                 ((c101 - c001) * (1.0f - fy) + (c111 - c011) * fy) * fz;
+    gradient.y = (c10 - c00) * (1.0f - fz) + (c11 - c01) * fz;
+    gradient.z = c1 - c0;
+    float length = glm::length(gradient);
+    if (!(length > 0.0f)) return SdfContactResult::Exact;
+
+    collision_normal = gradient / length;
+    penetration_depth = sphere_radius - distance;
+    return SdfContactResult::Hit;
+}
+
+} // namespace Collision
@@ -0,0 +1,74 @@
+#ifndef COLLISION_SDF_H
+#define COLLISION_SDF_H
+
+#include "Octree.h" // For AABB
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Collision {
+
+struct CollisionWorld;
+
+// Baked distance field for approximate sphere contacts against static
+// geometry: a few samples and a gradient instead of a triangle walk.
+// The volume is split into bricks of SDF_BRICK_CELLS^3 voxels and only bricks
+// within `band` of a triangle are stored, each with its own corner samples so
+// a lookup never crosses bricks. Distances are unsigned, like the triangle
+// contact (which pushes away from the closest point whatever side it is on),
+// so the level mesh need not be watertight.
+// Where the field can't stand in for the triangles, the query says so and the
+// caller falls back to the exact path: cells whose corners see different
+// surfaces (thin walls, edges, corners) are flagged at bake time, and centres
+// within a voxel of the surface (where interpolation cuts the corner of |d|)
+// are refused at query time.
+
+const int SDF_BRICK_CELLS = 8;
+const int SDF_BRICK_SAMPLES = SDF_BRICK_CELLS + 1;
+const int SDF_BRICK_SAMPLE_COUNT = SDF_BRICK_SAMPLES * SDF_BRICK_SAMPLES * SDF_BRICK_SAMPLES;
+const int SDF_BRICK_EXACT_WORDS = SDF_BRICK_CELLS * SDF_BRICK_CELLS * SDF_BRICK_CELLS / 64;
+const uint32_t SDF_EMPTY_BRICK = 0xFFFFFFFFu;
+
+struct CollisionSdfGrid {
+    glm::vec3 origin{0.0f};       // Corner of brick (0, 0, 0)
+    float voxel_size = 0.0f;
+    float band = 0.0f;            // Samples are exact up to here, clamped beyond
+    uint32_t brick_counts[3] = {0, 0, 0};
+};
+
+// Owning storage for a bake
+struct CollisionSdf {
+    CollisionSdfGrid grid;
+    std::vector<uint32_t> brick_table; // Per grid brick (x fastest): index into the bricks, or SDF_EMPTY_BRICK
+    std::vector<float> samples;        // SDF_BRICK_SAMPLE_COUNT per brick, x fastest
+    std::vector<uint64_t> exact_cells; // SDF_BRICK_EXACT_WORDS per brick; bit set = use the triangles
+};
+
+// Non-owning view, so the field can live in a mapped cache file
+struct CollisionSdfView {
+    CollisionSdfGrid grid;
+    const uint32_t* brick_table = nullptr;
+    uint32_t brick_count = 0;          // Stored bricks
+    const float* samples = nullptr;
+    const uint64_t* exact_cells = nullptr;
+};
+
+// Contacts for spheres up to max_radius can be answered from the field.
+// Reads the world's full-precision triangles, so it must not be quantized yet.
+CollisionSdf bakeCollisionSdf(const CollisionWorld& world, float voxel_size, float max_radius, int thread_count = 0);
+CollisionSdfView getCollisionSdfView(const CollisionSdf& sdf);
+uint32_t getCollisionSdfGridBrickCount(const CollisionSdfGrid& grid);
+
+enum class SdfContactResult {
+    Miss,  // No contact
+    Hit,   // Contact, normal and depth filled in
+    Exact  // The field can't answer here; use the triangles
+};
+
+SdfContactResult sampleSdfSphereContact(const CollisionSdfView& sdf, const glm::vec3& sphere_center,
+                                        float sphere_radius, glm::vec3& collision_normal,
+                                        float& penetration_depth);
+
+} // namespace Collision
+
+#endif // COLLISION_SDF_H
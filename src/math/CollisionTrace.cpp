@@ -0,0 +1,113 @@
+#include "CollisionTrace.h"
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace Collision {
+
+// Version 2 added the sweep filter; version 1 traces can't tell which
+// sweeps were filtered, so they are refused rather than replayed wrong
+const char* const COLLISION_TRACE_HEADER = "ogl-collision-trace 2";
+
+bool writeCollisionTrace(const std::string& path, const std::vector<CollisionTraceQuery>& queries) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cout << "Failed to write collision trace: " << path << std::endl;
+        return false;
+    }
+    // Round-trippable floats, so a replay runs the exact recorded queries
+    file.precision(std::numeric_limits<float>::max_digits10);
+    file << COLLISION_TRACE_HEADER << '\n';
+    for (const CollisionTraceQuery& query : queries) {
+        switch (query.type) {
+        case CollisionTraceQueryType::Contact:
+            file << "contact " << query.center.x << ' ' << query.center.y << ' ' << query.center.z << ' '
+                 << query.radius << '\n';
+            break;
+        case CollisionTraceQueryType::Sweep:
+            file << "sweep " << query.center.x << ' ' << query.center.y << ' ' << query.center.z << ' '
+                 << query.radius << ' ' << query.motion.x << ' ' << query.motion.y << ' ' << query.motion.z << ' '
+                 << (query.filter == CastFilter::Opposing ? "opposing" : "all") << '\n';
+            break;
+        case CollisionTraceQueryType::Tick:
+            file << "tick\n";
+            break;
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool loadCollisionTrace(const std::string& path, std::vector<CollisionTraceQuery>& queries) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string header;
+    if (!std::getline(file, header) || header != COLLISION_TRACE_HEADER) {
+        std::cout << "Not a collision trace (or one from an older version): " << path << std::endl;
+        return false;
+    }
+
+    queries.clear();
+    std::string type;
+    while (file >> type) {
+        CollisionTraceQuery query;
+        if (type == "contact") {
+            query.type = CollisionTraceQueryType::Contact;
+            file >> query.center.x >> query.center.y >> query.center.z >> query.radius;
+        } else if (type == "sweep") {
+            query.type = CollisionTraceQueryType::Sweep;
+            std::string filter;
+            file >> query.center.x >> query.center.y >> query.center.z >> query.radius >> query.motion.x >>
+                query.motion.y >> query.motion.z >> filter;
+            if (filter == "opposing") {
+                query.filter = CastFilter::Opposing;
+            } else if (file && filter != "all") {
+                std::cout << "Unknown sweep filter '" << filter << "' in " << path << std::endl;
+                return false;
+            }
+        } else if (type == "tick") {
+            query.type = CollisionTraceQueryType::Tick;
+        } else {
+            std::cout << "Unknown collision trace entry '" << type << "' in " << path << std::endl;
+            return false;
+        }
+        if (!file) {
+            std::cout << "Truncated collision trace: " << path << std::endl;
+            return false;
+        }
+        queries.push_back(query);
+    }
+    return true;
+}
+
+// Same calls on a CollisionWorld or a CollisionScene
+template <typename Structure>
+float runTraceQuery(const Structure& structure, const CollisionTraceQuery& query, CollisionQueryStats* stats) {
+    switch (query.type) {
+    case CollisionTraceQueryType::Contact: {
+        glm::vec3 normal(0.0f);
+        float depth = 0.0f;
+        return findDeepestSphereContact(structure, query.center, query.radius, normal, depth, stats) ? depth : -1.0f;
+    }
+    case CollisionTraceQueryType::Sweep: {
+        CollisionHit hit;
+        return castCollisionSphere(structure, query.center, query.radius, query.motion, hit, stats, query.filter)
+                   ? hit.t
+                   : -1.0f;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+float runCollisionTraceQuery(const CollisionWorld& world, const CollisionTraceQuery& query,
+                             CollisionQueryStats* stats) {
+    return runTraceQuery(world, query, stats);
+}
+
+float runCollisionTraceQuery(const CollisionScene& scene, const CollisionTraceQuery& query,
+                             CollisionQueryStats* stats) {
+    return runTraceQuery(scene, query, stats);
+}
+
+} // namespace Collision
@@ -0,0 +1,44 @@
+#ifndef COLLISION_TRACE_H
+#define COLLISION_TRACE_H
+
+#include "CollisionScene.h"
+#include "CollisionWorld.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace Collision {
+
+// Recorded sequence of the collision queries the game made, in order, so
+// they can be replayed headless (collision-bench) against any structure.
+// Stored as text, one query per line:
+//   contact cx cy cz radius                 (findDeepestSphereContact)
+//   sweep cx cy cz radius mx my mz filter   (castCollisionSphere; filter is
+//                                           "all" or "opposing")
+//   tick                                    (end of a simulation step)
+
+enum class CollisionTraceQueryType { Contact, Sweep, Tick };
+
+struct CollisionTraceQuery {
+    CollisionTraceQueryType type = CollisionTraceQueryType::Contact;
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+    glm::vec3 motion{0.0f}; // Sweeps only
+    CastFilter filter = CastFilter::All; // Sweeps only
+};
+
+bool writeCollisionTrace(const std::string& path, const std::vector<CollisionTraceQuery>& queries);
+// Returns false if the file is missing or malformed
+bool loadCollisionTrace(const std::string& path, std::vector<CollisionTraceQuery>& queries);
+
+// Runs one query through the same call runEngine makes. Returns the
+// penetration depth (contacts) or time of impact (sweeps), or -1 on a miss,
+// so replays on different structures can be compared. Ticks return 0.
+float runCollisionTraceQuery(const CollisionWorld& world, const CollisionTraceQuery& query,
+                             CollisionQueryStats* stats = nullptr);
+float runCollisionTraceQuery(const CollisionScene& scene, const CollisionTraceQuery& query,
+                             CollisionQueryStats* stats = nullptr);
+
+} // namespace Collision
+
+#endif // COLLISION_TRACE_H
@@ -0,0 +1,349 @@
+#include "CollisionWorld.h"
+#include "GeometryUtils.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+namespace Collision {
+
+// Replaces the packed Triangles and their SoA copy with a QuantizedTriangles,
+// blocked along the ranges the active structure hands out
+void quantizeCollisionWorld(CollisionWorld& world) {
+    std::vector<uint32_t> range_starts;
+    if (world.backend == CollisionBackend::Bvh) {
+        for (uint32_t i = 0; i < world.bvh.node_count; ++i) {
+            const Bvh4Node& node = world.bvh.nodes[i];
+            for (int c = 0; c < 4; ++c) {
+                if (node.triangle_count[c] > 0) range_starts.push_back(node.child[c]);
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < world.octree.node_count; ++i) {
+            const LinearOctreeNode& node = world.octree.nodes[i];
+            if (node.triangle_count > 0) range_starts.push_back(node.first_triangle);
+        }
+    }
+    world.quantized_storage = quantizeTriangles(getCollisionTriangles(world), getCollisionTriangleCount(world),
+                                                std::move(range_starts));
+    world.quantized = getQuantizedTrianglesView(world.quantized_storage);
+
+    world.octree_storage.triangles = std::vector<Triangle>();
+    world.octree.triangles = nullptr;
+    world.bvh_storage.triangles = std::vector<Triangle>();
+    world.bvh.triangles = nullptr;
+    world.triangle_soa_storage = MathUtils::TriangleSoA();
+    world.triangle_soa = MathUtils::TriangleSoAView();
+}
+
+CollisionWorld createCollisionWorld(const std::vector<Triangle>& triangles, const CollisionWorldSettings& settings) {
+    CollisionWorld world;
+    world.backend = settings.backend;
+
+    if (settings.backend == CollisionBackend::Bvh) {
+        world.bvh_storage = buildBvh(triangles, settings.bvh_max_leaf_triangles);
+        world.bvh = getBvhView(world.bvh_storage);
+    } else {
+        AABB bounds = settings.octree_auto_bounds ? computeOctreeBounds(triangles) : settings.octree_bounds;
+
+        // Bulk build in parallel, then freeze into the flat layout
+        size_t dropped = 0;
+        Octree octree = buildOctree(triangles, bounds, settings.octree_max_depth, settings.octree_triangles_per_node,
+                                    settings.octree_looseness, settings.build_threads, &dropped);
+        if (dropped > 0) {
+            std::cout << "Collision Warning: " << dropped
+                      << " triangles outside the octree bounds were dropped" << std::endl;
+        }
+        world.octree_storage = flattenOctree(octree);
+        world.octree = getLinearOctreeView(world.octree_storage);
+    }
+
+    world.triangle_soa_storage =
+        MathUtils::createTriangleSoA(getCollisionTriangles(world), getCollisionTriangleCount(world));
+    world.triangle_soa = MathUtils::getTriangleSoAView(world.triangle_soa_storage);
+
+    if (settings.sdf_voxel_size > 0.0f) {
+        world.sdf_storage = bakeCollisionSdf(world, settings.sdf_voxel_size, settings.sdf_max_radius,
+                                             settings.build_threads);
+        world.sdf = getCollisionSdfView(world.sdf_storage);
+    }
+    // After the bake, which reads the full-precision triangles
+    if (settings.quantize_triangles) quantizeCollisionWorld(world);
+    return world;
+}
+
+bool parseCollisionBackend(const std::string& name, CollisionBackend& backend) {
+    if (name == "octree") {
+        backend = CollisionBackend::Octree;
+        return true;
+    }
+    if (name == "bvh") {
+        backend = CollisionBackend::Bvh;
+        return true;
+    }
+    return false;
+}
+
+const char* getCollisionBackendName(CollisionBackend backend) {
+    return backend == CollisionBackend::Bvh ? "bvh" : "octree";
+}
+
+const Triangle* getCollisionTriangles(const CollisionWorld& world) {
+    return world.backend == CollisionBackend::Bvh ? world.bvh.triangles : world.octree.triangles;
+}
+
+uint32_t getCollisionTriangleCount(const CollisionWorld& world) {
+    return world.backend == CollisionBackend::Bvh ? world.bvh.triangle_count : world.octree.triangle_count;
+}
+
+Triangle getCollisionTriangle(const CollisionWorld& world, uint32_t index) {
+    const Triangle* triangles = getCollisionTriangles(world);
+    if (triangles) return triangles[index];
+    return decodeQuantizedTriangle(world.quantized, findQuantizedBlock(world.quantized, index), index);
+}
+
+size_t getCollisionWorldBytes(const CollisionWorld& world) {
+    size_t bytes = world.backend == CollisionBackend::Bvh ? world.bvh.node_count * sizeof(Bvh4Node)
+                                                          : world.octree.node_count * sizeof(LinearOctreeNode);
+    if (getCollisionTriangles(world)) bytes += getCollisionTriangleCount(world) * sizeof(Triangle);
+    bytes += static_cast<size_t>(world.triangle_soa.stride) * MathUtils::TRIANGLE_SOA_COMPONENTS * sizeof(float);
+    bytes += getQuantizedTrianglesBytes(world.quantized);
+    if (world.sdf.brick_count > 0) {
+        bytes += getCollisionSdfGridBrickCount(world.sdf.grid) * sizeof(uint32_t) +
+                 world.sdf.brick_count * (SDF_BRICK_SAMPLE_COUNT * sizeof(float) +
+                                          SDF_BRICK_EXACT_WORDS * sizeof(uint64_t));
+    }
+    return bytes;
+}
+
+// Quantized worlds keep no SoA copy: the range is decoded a batch at a time
+// into a small SoA on the stack and goes through the same kernels
+bool findDeepestQuantizedContact(const CollisionWorld& world, uint32_t first, uint32_t count,
+                                 const glm::vec3& sphere_center, float sphere_radius, glm::vec3& collision_normal,
+                                 float& penetration_depth, uint32_t* hit_count) {
+    // One 8-wide block of slack past the batch, as in createTriangleSoA
+    const uint32_t stride = COLLISION_DECODE_BATCH + 8;
+    float data[MathUtils::TRIANGLE_SOA_COMPONENTS * stride];
+    Triangle decoded[COLLISION_DECODE_BATCH];
+
+    bool hit = false;
+    for (uint32_t batch = first; batch < first + count; batch += COLLISION_DECODE_BATCH) {
+        uint32_t batch_count = std::min(COLLISION_DECODE_BATCH, first + count - batch);
+        decodeQuantizedTriangles(world.quantized, batch, batch_count, decoded);
+        for (uint32_t i = 0; i < batch_count; ++i) {
+            MathUtils::setSoATriangleRecord(data, stride, i, MathUtils::createTriangleRecord(decoded[i]));
+        }
+        for (uint32_t c = 0; c < MathUtils::TRIANGLE_SOA_COMPONENTS; ++c) {
+            std::fill(data + c * stride + batch_count, data + c * stride + batch_count + 8, 0.0f);
+        }
+
+        MathUtils::TriangleSoAView soa;
+        soa.data = data;
+        soa.count = batch_count;
+        soa.stride = stride;
+        if (MathUtils::findDeepestSphereContact(soa, 0, batch_count, sphere_center, sphere_radius,
+                                                collision_normal, penetration_depth, hit_count)) {
+            hit = true;
+        }
+    }
+    return hit;
+}
+
+bool findDeepestSphereContact(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& penetration_depth, CollisionQueryStats* stats) {
+    // Slightly padded box, as the original per-frame query used
+    AABB query = {sphere_center - glm::vec3(sphere_radius + 0.1f), sphere_center + glm::vec3(sphere_radius + 0.1f)};
+
+    penetration_depth = 0.0f;
+    bool hit = false;
+    uint32_t hit_count = 0;
+    const bool quantized = getCollisionTriangles(world) == nullptr;
+    visitCollisionRanges(world, query, [&](uint32_t first, uint32_t count) {
+        bool found = quantized ? findDeepestQuantizedContact(world, first, count, sphere_center, sphere_radius,
+                                                             collision_normal, penetration_depth,
+                                                             stats ? &hit_count : nullptr)
+                               : MathUtils::findDeepestSphereContact(world.triangle_soa, first, first + count,
+                                                                     sphere_center, sphere_radius, collision_normal,
+                                                                     penetration_depth, stats ? &hit_count : nullptr);
+        if (found) hit = true;
+        return true;
+    }, stats);
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_hit += hit_count;
+    }
+    return hit;
+}
+
+bool findApproximateSphereContact(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                                  glm::vec3& collision_normal, float& penetration_depth, CollisionQueryStats* stats) {
+    penetration_depth = 0.0f;
+    switch (sampleSdfSphereContact(world.sdf, sphere_center, sphere_radius, collision_normal, penetration_depth)) {
+    case SdfContactResult::Miss:
+    case SdfContactResult::Hit:
+        if (stats) {
+            ++stats->queries;
+            ++stats->field_answers;
+        }
+        return penetration_depth > 0.0f;
+    default:
+        return findDeepestSphereContact(world, sphere_center, sphere_radius, collision_normal, penetration_depth,
+                                        stats);
+    }
+}
+
+// Shared by the exact and approximate batch queries
+template <typename Query>
+void runSphereContactBatch(const std::vector<CollisionSphere>& spheres, std::vector<SphereContact>& contacts,
+                           WorkerPool* pool, CollisionQueryStats* stats, Query&& find_contact) {
+    // Spheres per chunk: enough to amortize the hand-off, small enough to balance
+    const size_t SPHERES_PER_CHUNK = 32;
+
+    contacts.resize(spheres.size());
+    std::mutex stats_mutex;
+    auto query = [&](size_t begin, size_t end) {
+        // Counted per chunk so threads only meet once per chunk
+        CollisionQueryStats chunk_stats;
+        for (size_t i = begin; i < end; ++i) {
+            SphereContact& contact = contacts[i];
+            contact.normal = glm::vec3(0.0f);
+            contact.hit = find_contact(spheres[i], contact, stats ? &chunk_stats : nullptr);
+        }
+        if (stats) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            addCollisionQueryStats(*stats, chunk_stats);
+        }
+    };
+    if (pool) {
+        parallelFor(*pool, spheres.size(), SPHERES_PER_CHUNK, query);
+    } else {
+        query(0, spheres.size());
+    }
+}
+
+void findDeepestSphereContacts(const CollisionWorld& world, const std::vector<CollisionSphere>& spheres,
+                               std::vector<SphereContact>& contacts, WorkerPool* pool, CollisionQueryStats* stats) {
+    runSphereContactBatch(spheres, contacts, pool, stats,
+                          [&](const CollisionSphere& sphere, SphereContact& contact, CollisionQueryStats* chunk_stats) {
+        return findDeepestSphereContact(world, sphere.center, sphere.radius, contact.normal, contact.depth,
+                                        chunk_stats);
+    });
+}
+
+void findApproximateSphereContacts(const CollisionWorld& world, const std::vector<CollisionSphere>& spheres,
+                                   std::vector<SphereContact>& contacts, WorkerPool* pool, CollisionQueryStats* stats) {
+    runSphereContactBatch(spheres, contacts, pool, stats,
+                          [&](const CollisionSphere& sphere, SphereContact& contact, CollisionQueryStats* chunk_stats) {
+        return findApproximateSphereContact(world, sphere.center, sphere.radius, contact.normal, contact.depth,
+                                            chunk_stats);
+    });
+}
+
+bool castCollisionRay(const CollisionWorld& world, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                      CollisionHit& hit, CollisionQueryStats* stats) {
+    bool found = false;
+    uint64_t hit_count = 0;
+    visitCollisionRayRanges(world, createCollisionRay(origin, direction), 0.0f, max_t,
+                            [&](uint32_t first, uint32_t count, float& closest_t) {
+        return visitCollisionRangeTriangles(world, first, count, [&](uint32_t i, const Triangle& triangle) {
+            float t;
+            if (MathUtils::intersectRayTriangle(origin, direction, triangle, closest_t, t)) {
+                ++hit_count;
+                closest_t = t;
+                hit.t = t;
+                hit.triangle = i;
+                found = true;
+            }
+            return true;
+        });
+    }, stats);
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_hit += hit_count;
+    }
+
+    if (found) {
+        const Triangle triangle = getCollisionTriangle(world, hit.triangle);
+        hit.normal = glm::normalize(glm::cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0));
+        if (glm::dot(hit.normal, direction) > 0.0f) hit.normal = -hit.normal;
+    }
+    return found;
+}
+
+bool isCollisionSegmentBlocked(const CollisionWorld& world, const glm::vec3& from, const glm::vec3& to,
+                               CollisionQueryStats* stats) {
+    glm::vec3 direction = to - from;
+    bool blocked = !visitCollisionRayRanges(world, createCollisionRay(from, direction), 0.0f, 1.0f,
+                                            [&](uint32_t first, uint32_t count, float& max_t) {
+        return visitCollisionRangeTriangles(world, first, count, [&](uint32_t, const Triangle& triangle) {
+            float t;
+            return !MathUtils::intersectRayTriangle(from, direction, triangle, max_t, t);
+        });
+    }, stats);
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_hit += blocked ? 1 : 0;
+    }
+    return blocked;
+}
+
+// A contact normal opposes the motion when its cosine with it is below minus
+// this, so walls whose normal is only horizontal up to rounding stay out of a
+// vertical cast
+const float CAST_OPPOSING_COSINE = 0.1f;
+
+bool isCastHitKept(CastFilter filter, const glm::vec3& normal, const glm::vec3& motion) {
+    return filter == CastFilter::All || glm::dot(normal, motion) <= -CAST_OPPOSING_COSINE * glm::length(motion);
+}
+
+bool castCollisionSphere(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                         const glm::vec3& motion, CollisionHit& hit, CollisionQueryStats* stats, CastFilter filter) {
+    bool found = false;
+    uint64_t hit_count = 0;
+    visitCollisionRayRanges(world, createCollisionRay(sphere_center, motion), sphere_radius, 1.0f,
+                            [&](uint32_t first, uint32_t count, float& closest_t) {
+        visitCollisionRangeTriangles(world, first, count, [&](uint32_t i, const Triangle& triangle) {
+            float t;
+            glm::vec3 normal;
+            if (MathUtils::sweepSphereTriangle(sphere_center, sphere_radius, motion, triangle, closest_t, t,
+                                               normal) &&
+                isCastHitKept(filter, normal, motion)) {
+                ++hit_count;
+                closest_t = t;
+                hit.t = t;
+                hit.normal = normal;
+                hit.triangle = i;
+                found = true;
+            }
+            return true;
+        });
+        // Nothing can come before an initial overlap
+        return !(found && closest_t == 0.0f);
+    }, stats);
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_hit += hit_count;
+    }
+    return found;
+}
+
+void printCollisionQueryStats(const CollisionQueryStats& stats, uint64_t frame_count) {
+    double frames = static_cast<double>(std::max<uint64_t>(frame_count, 1));
+    double queries = static_cast<double>(std::max<uint64_t>(stats.queries, 1));
+    std::cout << std::fixed << std::setprecision(1) << "Collision queries/frame " << stats.queries / frames
+              << ", nodes/frame " << stats.nodes_visited / frames
+              << ", triangles returned/frame " << stats.triangles_returned / frames
+              << ", hit/frame " << stats.triangles_hit / frames
+              << " | per query: nodes " << stats.nodes_visited / queries
+              << ", returned " << stats.triangles_returned / queries
+              << ", hit " << stats.triangles_hit / queries;
+    if (stats.field_answers > 0) {
+        std::cout << " | " << 100.0 * stats.field_answers / queries << "% from the distance field";
+    }
+    if (stats.cache_answers > 0) {
+        std::cout << " | " << 100.0 * stats.cache_answers / queries << "% from contact caches";
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+} // namespace Collision
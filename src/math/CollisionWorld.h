@@ -0,0 +1,222 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include "Bvh.h"
+#include "CollisionSdf.h"
+#include "Octree.h"
+#include "QuantizedTriangles.h"
+#include "TriangleBatch.h"
+#include "../utils/WorkerPool.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Collision {
+
+// Which acceleration structure answers the queries
+enum class CollisionBackend { Octree, Bvh };
+
+struct CollisionWorldSettings {
+    CollisionBackend backend = CollisionBackend::Octree;
+    // Octree
+    bool octree_auto_bounds = true; // Fit the root to the geometry
+    AABB octree_bounds = {glm::vec3(-100.0f), glm::vec3(100.0f)}; // Used if !octree_auto_bounds
+    int octree_max_depth = 8; // At most OCTREE_MAX_BUILD_DEPTH
+    int octree_triangles_per_node = 8;
+    float octree_looseness = 1.0f; // > 1 builds a loose octree
+    // BVH
+    int bvh_max_leaf_triangles = 4;
+    // Distance field for approximate contacts (CollisionSdf.h); > 0 bakes one
+    float sdf_voxel_size = 0.0f;
+    float sdf_max_radius = 1.2f; // Largest sphere the field answers for
+    // Keep only a QuantizedTriangles copy of the triangles (several times
+    // smaller, decoded by the queries) instead of Triangles plus the SoA
+    bool quantize_triangles = false;
+    // Threads for the octree build; <= 0 uses every hardware thread
+    int build_threads = 0;
+};
+
+// Static collision geometry behind one query interface. Queries only go
+// through the views, which point either into the owned storage (built
+// in-process, only the structure selected by `backend`) or into `mapping`
+// (loaded from a cache file, see CollisionCache.h). `triangle_soa` mirrors
+// the active structure's packed triangle array, so the ranges handed out by
+// visitCollisionRanges index both. A quantized world has neither: the
+// structure's triangle pointer and `triangle_soa` are empty, and `quantized`
+// holds the same packed array in compact form.
+// Move-only: a copy would leave the views pointing into the source's storage.
+struct CollisionWorld {
+    CollisionBackend backend = CollisionBackend::Octree;
+    LinearOctreeView octree;
+    BvhView bvh;
+    MathUtils::TriangleSoAView triangle_soa;
+    QuantizedTrianglesView quantized; // Empty unless quantized
+    CollisionSdfView sdf; // Empty unless baked
+
+    LinearOctree octree_storage;
+    Bvh bvh_storage;
+    MathUtils::TriangleSoA triangle_soa_storage;
+    QuantizedTriangles quantized_storage;
+    CollisionSdf sdf_storage;
+    std::shared_ptr<const void> mapping; // Keeps a mapped cache file alive
+
+    CollisionWorld() = default;
+    CollisionWorld(const CollisionWorld&) = delete;
+    CollisionWorld& operator=(const CollisionWorld&) = delete;
+    CollisionWorld(CollisionWorld&&) = default;
+    CollisionWorld& operator=(CollisionWorld&&) = default;
+};
+
+CollisionWorld createCollisionWorld(const std::vector<Triangle>& triangles, const CollisionWorldSettings& settings);
+
+// "octree" / "bvh"; returns false (and leaves backend untouched) if unknown
+bool parseCollisionBackend(const std::string& name, CollisionBackend& backend);
+const char* getCollisionBackendName(CollisionBackend backend);
+
+// Packed triangles of the active structure; null if the world is quantized
+const Triangle* getCollisionTriangles(const CollisionWorld& world);
+uint32_t getCollisionTriangleCount(const CollisionWorld& world);
+// One packed triangle, decoded if the world is quantized
+Triangle getCollisionTriangle(const CollisionWorld& world, uint32_t index);
+// Everything the queries read: nodes, triangles in either form, distance field
+size_t getCollisionWorldBytes(const CollisionWorld& world);
+
+// Triangles decoded at a time from a quantized world
+const uint32_t COLLISION_DECODE_BATCH = 32;
+
+// visitor(uint32_t triangle_index, const Triangle& triangle) -> bool, for
+// triangles [first, first + count) of the packed array. Quantized worlds
+// decode them a batch at a time on the stack.
+template <typename Visitor>
+bool visitCollisionRangeTriangles(const CollisionWorld& world, uint32_t first, uint32_t count, Visitor&& visitor) {
+    const Triangle* triangles = getCollisionTriangles(world);
+    if (triangles) {
+        for (uint32_t i = first; i < first + count; ++i) {
+            if (!visitor(i, triangles[i])) return false;
+        }
+        return true;
+    }
+    Triangle decoded[COLLISION_DECODE_BATCH];
+    for (uint32_t batch = first; batch < first + count; batch += COLLISION_DECODE_BATCH) {
+        uint32_t batch_count = std::min(COLLISION_DECODE_BATCH, first + count - batch);
+        decodeQuantizedTriangles(world.quantized, batch, batch_count, decoded);
+        for (uint32_t i = 0; i < batch_count; ++i) {
+            if (!visitor(batch + i, decoded[i])) return false;
+        }
+    }
+    return true;
+}
+
+// visitor(uint32_t first_triangle, uint32_t triangle_count) -> bool
+template <typename Visitor>
+bool visitCollisionRanges(const CollisionWorld& world, const AABB& query_bounds, Visitor&& visitor,
+                          CollisionQueryStats* stats = nullptr) {
+    if (world.backend == CollisionBackend::Bvh) {
+        return visitBvhRanges(world.bvh, query_bounds, visitor, stats);
+    }
+    return visitLinearOctreeNodes(world.octree, query_bounds, [&](const LinearOctreeNode& node) {
+        return visitor(node.first_triangle, node.triangle_count);
+    }, stats);
+}
+
+// visitor(uint32_t triangle_index, const Triangle& triangle) -> bool
+template <typename Visitor>
+bool visitCollisionTriangles(const CollisionWorld& world, const AABB& query_bounds, Visitor&& visitor) {
+    return visitCollisionRanges(world, query_bounds, [&](uint32_t first, uint32_t count) {
+        return visitCollisionRangeTriangles(world, first, count, visitor);
+    });
+}
+
+// visitor(uint32_t first_triangle, uint32_t triangle_count, float& max_t) -> bool,
+// nearest ranges first; see visitLinearOctreeRay for the pruning contract
+template <typename Visitor>
+bool visitCollisionRayRanges(const CollisionWorld& world, const CollisionRay& ray, float expand, float max_t,
+                             Visitor&& visitor, CollisionQueryStats* stats = nullptr) {
+    if (world.backend == CollisionBackend::Bvh) {
+        return visitBvhRay(world.bvh, ray, expand, max_t, visitor, stats);
+    }
+    return visitLinearOctreeRay(world.octree, ray, expand, max_t, [&](const LinearOctreeNode& node, float& t) {
+        return visitor(node.first_triangle, node.triangle_count, t);
+    }, stats);
+}
+
+struct CollisionHit {
+    float t = 0.0f;               // Along the cast: origin + direction * t
+    glm::vec3 normal{0.0f};       // Surface normal, facing back against the cast
+    uint32_t triangle = 0;        // Packed triangle index (see getCollisionTriangle)
+    uint32_t instance = 0;        // CollisionScene queries: the instance hit (see CollisionScene.h)
+};
+
+// Which triangles stop a sphere cast
+enum class CastFilter {
+    All, // Every one it touches, overlaps at t = 0 included
+    // Only those whose contact normal opposes the motion. A wall the sphere
+    // runs along, or still leans on, is left to the contact query instead of
+    // holding it at t = 0 (or catching it on an edge inside the wall).
+    Opposing
+};
+
+// Whether a cast hit with this contact normal stops a cast filtered by `filter`
+bool isCastHitKept(CastFilter filter, const glm::vec3& normal, const glm::vec3& motion);
+
+// Every query below adds its work to *stats if given (see
+// CollisionQueryStats); triangles_hit counts each triangle the narrow phase
+// found touching, not just the one reported.
+
+// Closest hit along origin + direction * t, t in [0, max_t]
+bool castCollisionRay(const CollisionWorld& world, const glm::vec3& origin, const glm::vec3& direction, float max_t,
+                      CollisionHit& hit, CollisionQueryStats* stats = nullptr);
+// Any hit between two points (line of sight); stops at the first one found
+bool isCollisionSegmentBlocked(const CollisionWorld& world, const glm::vec3& from, const glm::vec3& to,
+                               CollisionQueryStats* stats = nullptr);
+// First contact of a sphere moving by `motion`, t in [0, 1] (0 if it
+// starts out overlapping something), among the triangles `filter` keeps
+bool castCollisionSphere(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                         const glm::vec3& motion, CollisionHit& hit, CollisionQueryStats* stats = nullptr,
+                         CastFilter filter = CastFilter::All);
+
+// Deepest sphere contact against the world, using the batched narrow phase.
+// Same result as testing every candidate with checkSphereTriangleRecord
+// and keeping the deepest.
+bool findDeepestSphereContact(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& penetration_depth,
+                              CollisionQueryStats* stats = nullptr);
+
+struct CollisionSphere {
+    glm::vec3 center;
+    float radius;
+};
+
+struct SphereContact {
+    bool hit = false;
+    glm::vec3 normal{0.0f};
+    float depth = 0.0f;
+};
+
+// Batch form of findDeepestSphereContact: contacts[i] is exactly what the
+// single-sphere call returns for spheres[i]. With a pool, chunks of spheres
+// run on every thread; the world is only read, so no locking is needed.
+void findDeepestSphereContacts(const CollisionWorld& world, const std::vector<CollisionSphere>& spheres,
+                               std::vector<SphereContact>& contacts, WorkerPool* pool = nullptr,
+                               CollisionQueryStats* stats = nullptr);
+
+// Approximate contact from the baked distance field, for crowds where O(1)
+// matters more than triangle-exact contact. Falls back to
+// findDeepestSphereContact where the field can't answer (near thin features,
+// deep penetration, spheres larger than it was baked for, or no field).
+bool findApproximateSphereContact(const CollisionWorld& world, const glm::vec3& sphere_center, float sphere_radius,
+                                  glm::vec3& collision_normal, float& penetration_depth,
+                                  CollisionQueryStats* stats = nullptr);
+// Batch form, threaded like findDeepestSphereContacts
+void findApproximateSphereContacts(const CollisionWorld& world, const std::vector<CollisionSphere>& spheres,
+                                   std::vector<SphereContact>& contacts, WorkerPool* pool = nullptr,
+                                   CollisionQueryStats* stats = nullptr);
+
+// One log line: totals averaged over frame_count frames, plus per-query ratios
+void printCollisionQueryStats(const CollisionQueryStats& stats, uint64_t frame_count);
+
+} // namespace Collision
+
+#endif // COLLISION_WORLD_H
@@ -0,0 +1,121 @@
+#include "ContactCache.h"
+#include "GeometryUtils.h"
+
+namespace Collision {
+
+void resetContactCache(ContactCache& cache) {
+    cache.valid = false;
+    cache.region = createEmptyAABB();
+    cache.triangles.clear();
+    cache.instances.clear();
+    cache.triangle_indices.clear();
+    cache.soa = MathUtils::TriangleSoA();
+}
+
+glm::vec3 toWorldPoint(const CollisionInstance& instance, const glm::vec3& point) {
+    return glm::vec3(instance.transform * glm::vec4(point, 1.0f));
+}
+
+// Leaves the cache able to answer a query inside query_bounds: as it is if it
+// already covers them, refilled around them otherwise
+void prepareContactCache(const CollisionScene& scene, ContactCache& cache, const AABB& query_bounds,
+                         CollisionQueryStats* stats) {
+    if (cache.valid && containsAABB(cache.region, query_bounds) &&
+        !hasCollisionSceneChanged(scene, cache.scene_revision, cache.region)) {
+        // Changes elsewhere don't touch the cached triangles
+        cache.scene_revision = scene.revision;
+        ++cache.answers;
+        if (stats) ++stats->cache_answers;
+        return;
+    }
+
+    ++cache.refills;
+    cache.valid = true;
+    cache.scene_revision = scene.revision;
+    cache.region = growAABB(query_bounds, cache.margin);
+    cache.triangles.clear();
+    cache.instances.clear();
+    cache.triangle_indices.clear();
+
+    // Only the traversal is counted here; the queries count the triangles
+    CollisionQueryStats refill_stats;
+    CollisionQueryStats* traversal_stats = stats ? &refill_stats : nullptr;
+    visitAabbTree(scene.tree, cache.region, [&](uint32_t index) {
+        const CollisionInstance& instance = scene.instances[index];
+        const CollisionWorld& mesh = scene.meshes[instance.mesh];
+        AABB local_region = transformAABB(cache.region, instance.inverse_transform);
+        visitCollisionRanges(mesh, local_region, [&](uint32_t first, uint32_t count) {
+            return visitCollisionRangeTriangles(mesh, first, count, [&](uint32_t i, const Triangle& local) {
+                Triangle triangle = {toWorldPoint(instance, local.v0), toWorldPoint(instance, local.v1),
+                                     toWorldPoint(instance, local.v2)};
+                if (getTriangleAABB(triangle).intersects(cache.region)) {
+                    cache.triangles.push_back(triangle);
+                    cache.instances.push_back(index);
+                    cache.triangle_indices.push_back(i);
+                }
+                return true;
+            });
+        }, traversal_stats);
+        return true;
+    }, traversal_stats);
+    cache.soa = MathUtils::createTriangleSoA(cache.triangles);
+    if (stats) stats->nodes_visited += refill_stats.nodes_visited;
+}
+
+bool findDeepestSphereContact(const CollisionScene& scene, ContactCache& cache, const glm::vec3& sphere_center,
+                              float sphere_radius, glm::vec3& collision_normal, float& penetration_depth,
+                              CollisionQueryStats* stats) {
+    // Padded like the CollisionWorld query box
+    AABB query = {sphere_center - glm::vec3(sphere_radius + 0.1f), sphere_center + glm::vec3(sphere_radius + 0.1f)};
+    prepareContactCache(scene, cache, query, stats);
+
+    penetration_depth = 0.0f;
+    uint32_t hit_count = 0;
+    bool hit = MathUtils::findDeepestSphereContact(MathUtils::getTriangleSoAView(cache.soa), 0, cache.soa.count,
+                                                   sphere_center, sphere_radius, collision_normal, penetration_depth,
+                                                   stats ? &hit_count : nullptr);
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_returned += cache.soa.count;
+        stats->triangles_hit += hit_count;
+    }
+    return hit;
+}
+
+bool castCollisionSphere(const CollisionScene& scene, ContactCache& cache, const glm::vec3& sphere_center,
+                         float sphere_radius, const glm::vec3& motion, CollisionHit& hit,
+                         CollisionQueryStats* stats, CastFilter filter) {
+    glm::vec3 end = sphere_center + motion;
+    AABB query = {glm::min(sphere_center, end) - glm::vec3(sphere_radius),
+                  glm::max(sphere_center, end) + glm::vec3(sphere_radius)};
+    prepareContactCache(scene, cache, query, stats);
+
+    bool found = false;
+    float closest_t = 1.0f;
+    uint64_t hit_count = 0;
+    for (size_t i = 0; i < cache.triangles.size(); ++i) {
+        float t;
+        glm::vec3 normal;
+        if (MathUtils::sweepSphereTriangle(sphere_center, sphere_radius, motion, cache.triangles[i], closest_t, t,
+                                           normal) &&
+            isCastHitKept(filter, normal, motion)) {
+            ++hit_count;
+            closest_t = t;
+            hit.t = t;
+            hit.normal = normal;
+            hit.triangle = cache.triangle_indices[i];
+            hit.instance = cache.instances[i];
+            found = true;
+            // Nothing can come before an initial overlap
+            if (closest_t == 0.0f) break;
+        }
+    }
+    if (stats) {
+        ++stats->queries;
+        stats->triangles_returned += cache.triangles.size();
+        stats->triangles_hit += hit_count;
+    }
+    return found;
+}
+
+} // namespace Collision
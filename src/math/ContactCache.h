@@ -0,0 +1,55 @@
+#ifndef CONTACT_CACHE_H
+#define CONTACT_CACHE_H
+
+#include "CollisionScene.h"
+#include "TriangleBatch.h"
+#include <cstdint>
+#include <vector>
+
+namespace Collision {
+
+// Per-body memory of the static geometry around it. A refill gathers every
+// triangle near the body's query box, grown by a margin, into world space
+// (the ground and walls it stands against, and whatever it is about to
+// reach). Later queries whose box still lies inside that region, against an
+// unchanged scene, test only those triangles: no tree or octree traversal,
+// and one SIMD pass over a short SoA. A body standing still or walking
+// slowly refills every few ticks at most.
+// Answers match the full scene queries (up to rounding, where an instance
+// transform isn't the identity): a triangle outside the region can't reach a
+// query box inside it. A scene change (see CollisionScene::change_bounds)
+// only empties the caches whose region it reaches, so a platform moving
+// elsewhere in the level costs nothing, and one moving near a body costs a
+// refill per tick: the full query plus the region's extra triangles.
+
+struct ContactCache {
+    AABB region = createEmptyAABB(); // Query boxes inside this are answered from the cache
+    uint64_t scene_revision = 0; // Scene revision the region was last checked against
+    bool valid = false;
+    float margin = 1.0f; // Region = the refilling query's box grown by this
+    // The cached triangles, in world space, with where they came from
+    std::vector<Triangle> triangles;
+    std::vector<uint32_t> instances;
+    std::vector<uint32_t> triangle_indices;
+    MathUtils::TriangleSoA soa; // Records of `triangles` for the batched narrow phase
+    // Queries answered from the cache and refills, for tuning `margin`
+    uint64_t answers = 0;
+    uint64_t refills = 0;
+};
+
+// Forgets the cached region; the next query refills it
+void resetContactCache(ContactCache& cache);
+
+// The CollisionScene queries, answered from the cache when they can be and
+// refilling it around the query otherwise. Stats count the query once,
+// plus the refill's traversal when there is one.
+bool findDeepestSphereContact(const CollisionScene& scene, ContactCache& cache, const glm::vec3& sphere_center,
+                              float sphere_radius, glm::vec3& collision_normal, float& penetration_depth,
+                              CollisionQueryStats* stats = nullptr);
+bool castCollisionSphere(const CollisionScene& scene, ContactCache& cache, const glm::vec3& sphere_center,
+                         float sphere_radius, const glm::vec3& motion, CollisionHit& hit,
+                         CollisionQueryStats* stats = nullptr, CastFilter filter = CastFilter::All);
+
+} // namespace Collision
+
+#endif // CONTACT_CACHE_H
@@ -166,3 +166,206 @@ bool MathUtils::checkSphereTriangleCollision(const glm::vec3& sphere_center, flo
     }
     return false;
 }
+
+MathUtils::TriangleRecord MathUtils::createTriangleRecord(const Collision::Triangle& triangle) {
+    TriangleRecord record;
+    record.a = triangle.v0;
+    record.ab = triangle.v1 - triangle.v0;
+    record.ac = triangle.v2 - triangle.v0;
+    record.normal = glm::normalize(glm::cross(record.ab, record.ac));
+    record.ab_ab = glm::dot(record.ab, record.ab);
+    record.ab_ac = glm::dot(record.ab, record.ac);
+    record.ac_ac = glm::dot(record.ac, record.ac);
+    glm::vec3 bc = record.ac - record.ab;
+    record.inv_ab_ab = 1.0f / record.ab_ab;
+    record.inv_ac_ac = 1.0f / record.ac_ac;
+    record.inv_bc_bc = 1.0f / glm::dot(bc, bc);
+    record.bounds = Collision::getTriangleAABB(triangle);
+    return record;
+}
+
+// Same regions, in the same order, as closestPointOnTriangle. The dot
+// products against B and C follow from the ones against A:
+// ab.(p-b) = d1 - ab.ab, ac.(p-b) = d2 - ab.ac, ab.(p-c) = d1 - ab.ac,
+// ac.(p-c) = d2 - ac.ac. Keep in step with the SIMD kernel in
+// TriangleBatchKernel.h, which must produce bit-identical results.
+glm::vec3 MathUtils::closestPointOnTriangleRecord(const glm::vec3& p, const TriangleRecord& record) {
+    glm::vec3 ap = p - record.a;
+    float d1 = glm::dot(record.ab, ap);
+    float d2 = glm::dot(record.ac, ap);
+    float d3 = d1 - record.ab_ab;
+    float d4 = d2 - record.ab_ac;
+    float d5 = d1 - record.ab_ac;
+    float d6 = d2 - record.ac_ac;
+
+    if (d1 <= 0.0f && d2 <= 0.0f) return record.a;
+    if (d3 >= 0.0f && d4 <= d3) return record.a + record.ab;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        return record.a + glm::clamp(d1 * record.inv_ab_ab, 0.0f, 1.0f) * record.ab;
+    }
+
+    if (d6 >= 0.0f && d5 <= d6) return record.a + record.ac;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        return record.a + glm::clamp(d2 * record.inv_ac_ac, 0.0f, 1.0f) * record.ac;
+    }
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        return (record.a + record.ab) +
+               glm::clamp((d4 - d3) * record.inv_bc_bc, 0.0f, 1.0f) * (record.ac - record.ab);
+    }
+
+    return p - glm::dot(ap, record.normal) * record.normal;
+}
+
+bool MathUtils::checkSphereTriangleRecord(const glm::vec3& sphere_center, float sphere_radius, const TriangleRecord& record, glm::vec3& collision_normal, float& penetration_depth) {
+    const Collision::AABB& bounds = record.bounds;
+    if (sphere_center.x < bounds.min.x - sphere_radius || sphere_center.x > bounds.max.x + sphere_radius ||
+        sphere_center.y < bounds.min.y - sphere_radius || sphere_center.y > bounds.max.y + sphere_radius ||
+        sphere_center.z < bounds.min.z - sphere_radius || sphere_center.z > bounds.max.z + sphere_radius) {
+        return false;
+    }
+
+    glm::vec3 vec_from_closest_point = sphere_center - closestPointOnTriangleRecord(sphere_center, record);
+    float distance_sq = glm::dot(vec_from_closest_point, vec_from_closest_point);
+    if (!(distance_sq < sphere_radius * sphere_radius)) return false; // Also rejects NaN (degenerate)
+
+    float distance = glm::sqrt(distance_sq);
+    penetration_depth = sphere_radius - distance;
+    collision_normal = distance == 0.0f ? record.normal : glm::normalize(vec_from_closest_point);
+    return true;
+}
+
+bool MathUtils::intersectRayTriangle(const glm::vec3& origin, const glm::vec3& direction, const Collision::Triangle& triangle, float max_t, float& hit_t) {
+    // Moller-Trumbore
+    glm::vec3 edge1 = triangle.v1 - triangle.v0;
+    glm::vec3 edge2 = triangle.v2 - triangle.v0;
+    glm::vec3 p = glm::cross(direction, edge2);
+    float det = glm::dot(edge1, p);
+    if (std::fabs(det) < 1e-12f) return false; // Parallel or degenerate
+
+    float inv_det = 1.0f / det;
+    glm::vec3 s = origin - triangle.v0;
+    float u = glm::dot(s, p) * inv_det;
+    if (u < 0.0f || u > 1.0f) return false;
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) return false;
+
+    float t = glm::dot(edge2, q) * inv_det;
+    if (t < 0.0f || t > max_t) return false;
+    hit_t = t;
+    return true;
+}
+
+// For a point on the triangle's plane
+bool isPointInTriangle(const glm::vec3& p, const Collision::Triangle& triangle) {
+    glm::vec3 normal = glm::cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0);
+    return glm::dot(glm::cross(triangle.v1 - triangle.v0, p - triangle.v0), normal) >= 0.0f &&
+           glm::dot(glm::cross(triangle.v2 - triangle.v1, p - triangle.v1), normal) >= 0.0f &&
+           glm::dot(glm::cross(triangle.v0 - triangle.v2, p - triangle.v2), normal) >= 0.0f;
+}
+
+// Smallest t in [0, max_t] at which origin + direction * t is `radius` away
+// from `point`. The start is assumed to be outside that distance.
+bool sweepPointSphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& point, float radius, float max_t, float& hit_t) {
+    glm::vec3 m = origin - point;
+    float a = glm::dot(direction, direction);
+    float b = glm::dot(m, direction);
+    float c = glm::dot(m, m) - radius * radius;
+    if (a == 0.0f || b >= 0.0f) return false; // Not approaching
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return false;
+    float t = (-b - std::sqrt(discriminant)) / a;
+    if (t < 0.0f || t > max_t) return false;
+    hit_t = t;
+    return true;
+}
+
+// Same against the infinite cylinder around edge [p, q]; only hits whose
+// closest edge point lies within the segment count (the end caps are the
+// vertex spheres)
+bool sweepPointCylinder(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& p, const glm::vec3& q, float radius, float max_t, float& hit_t) {
+    glm::vec3 e = q - p;
+    glm::vec3 m = origin - p;
+    float ee = glm::dot(e, e);
+    float ed = glm::dot(e, direction);
+    float em = glm::dot(e, m);
+    float a = ee * glm::dot(direction, direction) - ed * ed;
+    float b = ee * glm::dot(m, direction) - ed * em;
+    float c = ee * (glm::dot(m, m) - radius * radius) - em * em;
+    if (ee == 0.0f || a <= 1e-12f * ee || b >= 0.0f) return false; // Parallel or not approaching
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return false;
+    float t = (-b - std::sqrt(discriminant)) / a;
+    if (t < 0.0f || t > max_t) return false;
+    float s = (em + ed * t) / ee;
+    if (s < 0.0f || s > 1.0f) return false;
+    hit_t = t;
+    return true;
+}
+
+bool MathUtils::sweepSphereTriangle(const glm::vec3& sphere_center, float sphere_radius, const glm::vec3& motion, const Collision::Triangle& triangle, float max_t, float& hit_t, glm::vec3& contact_normal) {
+    glm::vec3 closest_point = closestPointOnTriangle(sphere_center, triangle.v0, triangle.v1, triangle.v2);
+    glm::vec3 separation = sphere_center - closest_point;
+    glm::vec3 normal = glm::cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0);
+    if (glm::dot(normal, normal) == 0.0f) return false; // Degenerate
+
+    normal = glm::normalize(normal);
+    if (glm::dot(separation, separation) < sphere_radius * sphere_radius) {
+        hit_t = 0.0f;
+        float distance = glm::length(separation);
+        contact_normal = distance > 0.0f ? separation / distance : normal;
+        return true;
+    }
+
+    // Face: the sphere touches the plane with its leading point inside the triangle
+    float distance = glm::dot(sphere_center - triangle.v0, normal);
+    if (distance < 0.0f) {
+        normal = -normal;
+        distance = -distance;
+    }
+    float approach = -glm::dot(motion, normal);
+    if (approach > 0.0f) {
+        float t = (distance - sphere_radius) / approach;
+        if (t >= 0.0f && t <= max_t) {
+            glm::vec3 touch = sphere_center + motion * t - normal * sphere_radius;
+            if (isPointInTriangle(touch, triangle)) {
+                hit_t = t;
+                contact_normal = normal;
+                return true;
+            }
+        }
+    }
+
+    // Otherwise the first contact is on an edge or a vertex
+    float best_t = max_t;
+    bool hit = false;
+    float t;
+    const glm::vec3* vertices[3] = {&triangle.v0, &triangle.v1, &triangle.v2};
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec3& a = *vertices[i];
+        const glm::vec3& b = *vertices[(i + 1) % 3];
+        if (sweepPointSphere(sphere_center, motion, a, sphere_radius, best_t, t)) {
+            best_t = t;
+            hit = true;
+        }
+        if (sweepPointCylinder(sphere_center, motion, a, b, sphere_radius, best_t, t)) {
+            best_t = t;
+            hit = true;
+        }
+    }
+    if (!hit) return false;
+
+    glm::vec3 center = sphere_center + motion * best_t;
+    glm::vec3 away = center - closestPointOnTriangle(center, triangle.v0, triangle.v1, triangle.v2);
+    float length = glm::length(away);
+    hit_t = best_t;
+    contact_normal = length > 0.0f ? away / length : normal;
+    return true;
+}
@@ -42,6 +42,42 @@ bool checkSphereTriangleCollision(const glm::vec3 &sphere_center,
                                   glm::vec3 &collision_normal,
                                   float &penetration_depth);
 
+// Everything the sphere test derives from a triangle's vertices, computed
+// once at load. With the edge dot products, classifying a point into a
+// Voronoi region takes two dot products instead of six, and the edge
+// parameters are multiplies instead of divides.
+struct TriangleRecord {
+    glm::vec3 a;        // First vertex
+    glm::vec3 ab, ac;   // Edges from `a`
+    glm::vec3 normal;   // Unit plane normal (NaN for degenerate triangles)
+    float ab_ab, ab_ac, ac_ac;             // Edge dot products
+    float inv_ab_ab, inv_ac_ac, inv_bc_bc; // Reciprocal squared edge lengths
+    Collision::AABB bounds;                // For cheap rejection
+};
+
+TriangleRecord createTriangleRecord(const Collision::Triangle &triangle);
+glm::vec3 closestPointOnTriangleRecord(const glm::vec3 &point,
+                                       const TriangleRecord &record);
+// checkSphereTriangleCollision on a precomputed record; spheres outside the
+// triangle's bounds are rejected before any region work
+bool checkSphereTriangleRecord(const glm::vec3 &sphere_center,
+                               float sphere_radius,
+                               const TriangleRecord &record,
+                               glm::vec3 &collision_normal,
+                               float &penetration_depth);
+
+// Casts. Points along a cast are origin + direction * t, and only hits with
+// t in [0, max_t] count. Triangles are double-sided.
+bool intersectRayTriangle(const glm::vec3 &origin, const glm::vec3 &direction,
+                          const Collision::Triangle &triangle, float max_t,
+                          float &hit_t);
+// First time a sphere moving by `motion` touches the triangle (t = 0 if it
+// already overlaps). contact_normal points from the triangle to the sphere.
+bool sweepSphereTriangle(const glm::vec3 &sphere_center, float sphere_radius,
+                         const glm::vec3 &motion,
+                         const Collision::Triangle &triangle, float max_t,
+                         float &hit_t, glm::vec3 &contact_normal);
+
 } // namespace MathUtils
 
 #endif
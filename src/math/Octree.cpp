@@ -1,6 +1,12 @@
 #include "Octree.h"
+#include <cmath>
 #include <algorithm> // For std::min/max
+#include <atomic>
 #include <iostream>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <unordered_map>
 
 namespace Collision {
 
@@ -25,10 +31,64 @@ AABB getTriangleAABB(const Triangle& triangle) {
     };
 }
 
+AABB createEmptyAABB() {
+    float inf = std::numeric_limits<float>::infinity();
+    return {glm::vec3(inf), glm::vec3(-inf)};
+}
+
+void expandAABB(AABB& box, const AABB& other) {
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+float getAABBHalfArea(const AABB& box) {
+    glm::vec3 extent = box.max - box.min;
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f) return 0.0f;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+AABB transformAABB(const AABB& box, const glm::mat4& transform) {
+    // Arvo: each output axis takes the smaller/larger of every matrix term
+    // applied to the input min/max
+    AABB result = {glm::vec3(transform[3]), glm::vec3(transform[3])};
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            float a = transform[column][row] * box.min[column];
+            float b = transform[column][row] * box.max[column];
+            result.min[row] += std::min(a, b);
+            result.max[row] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+AABB growAABB(const AABB& box, float margin) {
+    return {box.min - glm::vec3(margin), box.max + glm::vec3(margin)};
+}
+
+bool containsAABB(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+CollisionRay createCollisionRay(const glm::vec3& origin, const glm::vec3& direction) {
+    CollisionRay ray;
+    ray.origin = origin;
+    ray.direction = direction;
+    for (int axis = 0; axis < 3; ++axis) {
+        ray.inv_direction[axis] = std::fabs(direction[axis]) > 1e-20f ? 1.0f / direction[axis] : 1e30f;
+    }
+    return ray;
+}
+
 
 // --- OctreeNode Free Functions ---
-void initOctreeNode(OctreeNode* node, const AABB& bounds) {
+void initOctreeNode(OctreeNode* node, const AABB& bounds, float looseness) {
     node->bounds = bounds;
+    // Loose bounds: the cell grown around its centre by the looseness factor
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    glm::vec3 loose_half_size = (bounds.max - bounds.min) * 0.5f * looseness;
+    node->loose_bounds = AABB{center - loose_half_size, center + loose_half_size};
     for (int i = 0; i < 8; ++i) {
         node->children[i] = nullptr;
     }
@@ -37,20 +97,25 @@ void initOctreeNode(OctreeNode* node, const AABB& bounds) {
 }
 
 // Forward declarations for mutual recursion
-void insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node);
+bool insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node, float looseness);
 
 // Helper to subdivide a node
-void subdivideNode(OctreeNode* node, int current_depth, int max_depth, int triangles_per_node) {
+void subdivideNode(OctreeNode* node, int current_depth, int max_depth, int triangles_per_node, float looseness) {
     glm::vec3 center = (node->bounds.min + node->bounds.max) * 0.5f;
 
-    node->children[0] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[0].get(), AABB{node->bounds.min, center});
-    node->children[1] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[1].get(), AABB{glm::vec3(center.x, node->bounds.min.y, node->bounds.min.z), glm::vec3(node->bounds.max.x, center.y, center.z)});
-    node->children[2] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[2].get(), AABB{glm::vec3(node->bounds.min.x, center.y, node->bounds.min.z), glm::vec3(center.x, node->bounds.max.y, center.z)});
-    node->children[3] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[3].get(), AABB{glm::vec3(center.x, center.y, node->bounds.min.z), glm::vec3(node->bounds.max.x, node->bounds.max.y, center.z)});
-    node->children[4] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[4].get(), AABB{glm::vec3(node->bounds.min.x, node->bounds.min.y, center.z), glm::vec3(center.x, center.y, node->bounds.max.z)});
-    node->children[5] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[5].get(), AABB{glm::vec3(center.x, node->bounds.min.y, center.z), glm::vec3(node->bounds.max.x, center.y, node->bounds.max.z)});
-    node->children[6] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[6].get(), AABB{glm::vec3(node->bounds.min.x, center.y, center.z), glm::vec3(center.x, node->bounds.max.y, node->bounds.max.z)});
-    node->children[7] = std::make_unique<OctreeNode>(); initOctreeNode(node->children[7].get(), AABB{center, node->bounds.max});
+    // Child i covers the octant selected by bits x=1, y=2, z=4 (see getContainingOctant)
+    for (int i = 0; i < 8; ++i) {
+        glm::vec3 child_min(
+            (i & 1) ? center.x : node->bounds.min.x,
+            (i & 2) ? center.y : node->bounds.min.y,
+            (i & 4) ? center.z : node->bounds.min.z);
+        glm::vec3 child_max(
+            (i & 1) ? node->bounds.max.x : center.x,
+            (i & 2) ? node->bounds.max.y : center.y,
+            (i & 4) ? node->bounds.max.z : center.z);
+        node->children[i] = std::make_unique<OctreeNode>();
+        initOctreeNode(node->children[i].get(), AABB{child_min, child_max}, looseness);
+    }
 
     node->is_leaf = false; // Node is no longer a leaf
 
@@ -61,7 +126,7 @@ void subdivideNode(OctreeNode* node, int current_depth, int max_depth, int trian
     for (const auto& tri : triangles_to_redistribute) {
         int octant_index = getContainingOctant(node, tri); // Which child does this triangle fit into?
         if (octant_index != -1 && node->children[octant_index]) {
-            insertTriangleIntoOctree(node->children[octant_index].get(), tri, current_depth + 1, max_depth, triangles_per_node);
+            insertTriangleIntoOctree(node->children[octant_index].get(), tri, current_depth + 1, max_depth, triangles_per_node, looseness);
         } else {
             // If it doesn't fit into one child, add it back to the current (now subdivided) node.
             node->triangles.push_back(tri);
@@ -71,15 +136,39 @@ void subdivideNode(OctreeNode* node, int current_depth, int max_depth, int trian
 
 
 // --- Octree Free Functions ---
-Octree createOctree(const AABB& bounds, int max_depth, int triangles_per_node) {
+Octree createOctree(const AABB& bounds, int max_depth, int triangles_per_node, float looseness) {
+    if (max_depth > OCTREE_MAX_BUILD_DEPTH) {
+        std::cout << "Octree: max depth " << max_depth << " clamped to " << OCTREE_MAX_BUILD_DEPTH << std::endl;
+        max_depth = OCTREE_MAX_BUILD_DEPTH;
+    }
     Octree octree;
     octree.root = std::make_unique<OctreeNode>();
-    initOctreeNode(octree.root.get(), bounds);
+    // The root cell is the given box; only children are loosened
+    initOctreeNode(octree.root.get(), bounds, 1.0f);
     octree.max_depth = max_depth;
     octree.triangles_per_node = triangles_per_node;
+    octree.looseness = looseness;
     return octree;
 }
 
+AABB computeOctreeBounds(const std::vector<Triangle>& triangles) {
+    if (triangles.empty()) {
+        return AABB{glm::vec3(-1.0f), glm::vec3(1.0f)};
+    }
+
+    AABB bounds = createEmptyAABB();
+    for (const auto& triangle : triangles) {
+        expandAABB(bounds, getTriangleAABB(triangle));
+    }
+
+    // Cubic cells subdivide evenly; pad so nothing sits exactly on the border
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    glm::vec3 extent = bounds.max - bounds.min;
+    float half_size = std::max(extent.x, std::max(extent.y, extent.z)) * 0.5f;
+    half_size = half_size * 1.01f + 0.01f;
+    return AABB{center - glm::vec3(half_size), center + glm::vec3(half_size)};
+}
+
 bool isTriangleWhollyContainedInAABB(const AABB& aabb, const Triangle& triangle) {
     return aabb.contains(triangle.v0) && aabb.contains(triangle.v1) && aabb.contains(triangle.v2);
 }
@@ -87,28 +176,49 @@ bool isTriangleWhollyContainedInAABB(const AABB& aabb, const Triangle& triangle)
 int getContainingOctant(const OctreeNode* node, const Triangle& triangle) {
     if (node->is_leaf) return -1; // Not subdivided yet
 
-    for (int i = 0; i < 8; ++i) {
-        if (node->children[i] && isTriangleWhollyContainedInAABB(node->children[i]->bounds, triangle)) {
-            return i; // Found an octant that wholly contains the triangle
+    // Only one child is a candidate. Per axis, it is on the side of the split
+    // the triangle lies on, the lower one if it lies in the plane itself (cells
+    // are closed, so both hold it there, and the old first-match scan tried
+    // lower octants first). That makes it the same child the scan found for a
+    // tight octree. A triangle across the plane can only fit a loose child; the
+    // side holding its centroid leaves it the most slack.
+    glm::vec3 center = (node->bounds.min + node->bounds.max) * 0.5f;
+    AABB box = getTriangleAABB(triangle);
+    glm::vec3 centroid = (triangle.v0 + triangle.v1 + triangle.v2) / 3.0f;
+    int octant = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        bool upper;
+        if (box.max[axis] <= center[axis]) {
+            upper = false;
+        } else if (box.min[axis] >= center[axis]) {
+            upper = true;
+        } else {
+            upper = centroid[axis] >= center[axis];
         }
+        if (upper) octant |= 1 << axis;
+    }
+
+    if (node->children[octant] && isTriangleWhollyContainedInAABB(node->children[octant]->loose_bounds, triangle)) {
+        return octant;
     }
     return -1; // Triangle spans multiple octants or is outside
 }
 
-void insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node) {
+bool insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node, float looseness) {
     AABB triangle_aabb = getTriangleAABB(triangle);
 
-    // If triangle does not intersect node bounds, return
-    if (!node->bounds.intersects(triangle_aabb)) {
-        return;
+    // If triangle does not intersect node bounds, it is dropped
+    if (!node->loose_bounds.intersects(triangle_aabb)) {
+        return false;
     }
 
     // Condition to subdivide or add to current node
     // If max depth reached, OR node is a leaf AND has fewer than `triangles_per_node` triangles,
     // then add the triangle to this node.
-    if (current_depth >= max_depth || (node->is_leaf && node->triangles.size() < triangles_per_node)) {
+    if (current_depth >= std::min(max_depth, OCTREE_MAX_BUILD_DEPTH) ||
+        (node->is_leaf && node->triangles.size() < triangles_per_node)) {
         node->triangles.push_back(triangle);
-        return;
+        return true;
     }
 
     // If we are here, the node either needs to subdivide or is already subdivided,
@@ -116,7 +226,7 @@ void insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int cu
 
     // If it's a leaf node but exceeds triangle limit and can subdivide:
     if (node->is_leaf) {
-        subdivideNode(node, current_depth, max_depth, triangles_per_node);
+        subdivideNode(node, current_depth, max_depth, triangles_per_node, looseness);
         // After subdivision, existing triangles are redistributed.
         // Now, this `triangle` also needs to be handled by the logic below.
     }
@@ -125,16 +235,108 @@ void insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int cu
     int octant_index = getContainingOctant(node, triangle);
     if (octant_index != -1 && node->children[octant_index]) {
         // It fits wholly into a child, insert it there
-        insertTriangleIntoOctree(node->children[octant_index].get(), triangle, current_depth + 1, max_depth, triangles_per_node);
-    } else {
-        // Triangle spans multiple octants or doesn't fit wholly into one child.
-        // Add it to the current node.
-        node->triangles.push_back(triangle);
+        return insertTriangleIntoOctree(node->children[octant_index].get(), triangle, current_depth + 1, max_depth, triangles_per_node, looseness);
+    }
+    // Triangle spans multiple octants or doesn't fit wholly into one child.
+    // Add it to the current node.
+    node->triangles.push_back(triangle);
+    return true;
+}
+
+// --- Bulk Build ---
+
+// Subtrees smaller than this are not worth a thread
+const size_t PARALLEL_BUILD_MIN_TRIANGLES = 2048;
+
+struct OctreeBuildContext {
+    int max_depth;
+    int triangles_per_node;
+    float looseness;
+    std::atomic<int> free_threads; // Worker threads that may still be spawned
+};
+
+// Builds the subtree of `node` from the triangles routed to it. Mirrors the
+// incremental rules: a node holds up to triangles_per_node triangles as a
+// leaf, and past that it subdivides (unless at max depth). Triangles that
+// fit a child's loose bounds move down; the rest stay, in insertion order.
+void buildOctreeNode(OctreeNode* node, std::vector<Triangle> triangles, int depth, OctreeBuildContext& ctx) {
+    if (depth >= ctx.max_depth || triangles.size() <= static_cast<size_t>(ctx.triangles_per_node)) {
+        node->triangles = std::move(triangles);
+        return;
+    }
+
+    // Subdivide with no triangles, then partition everything at once
+    subdivideNode(node, depth, ctx.max_depth, ctx.triangles_per_node, ctx.looseness);
+    std::vector<Triangle> child_triangles[8];
+    for (const auto& triangle : triangles) {
+        int octant = getContainingOctant(node, triangle);
+        if (octant != -1) {
+            child_triangles[octant].push_back(triangle);
+        } else {
+            node->triangles.push_back(triangle);
+        }
+    }
+    triangles.clear();
+    triangles.shrink_to_fit();
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 8; ++i) {
+        if (child_triangles[i].empty()) continue;
+
+        bool spawn = false;
+        if (child_triangles[i].size() >= PARALLEL_BUILD_MIN_TRIANGLES) {
+            int free_threads = ctx.free_threads.load();
+            while (free_threads > 0 && !ctx.free_threads.compare_exchange_weak(free_threads, free_threads - 1)) {
+            }
+            spawn = free_threads > 0;
+        }
+
+        OctreeNode* child = node->children[i].get();
+        if (spawn) {
+            workers.emplace_back([child, &child_triangles, i, depth, &ctx]() {
+                buildOctreeNode(child, std::move(child_triangles[i]), depth + 1, ctx);
+                ctx.free_threads.fetch_add(1);
+            });
+        } else {
+            buildOctreeNode(child, std::move(child_triangles[i]), depth + 1, ctx);
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+Octree buildOctree(const std::vector<Triangle>& triangles, const AABB& bounds, int max_depth, int triangles_per_node,
+                   float looseness, int thread_count, size_t* dropped_count) {
+    Octree octree = createOctree(bounds, max_depth, triangles_per_node, looseness);
+
+    // Same rejection test insertTriangleIntoOctree applies at the root
+    std::vector<Triangle> inside;
+    inside.reserve(triangles.size());
+    for (const auto& triangle : triangles) {
+        if (octree.root->loose_bounds.intersects(getTriangleAABB(triangle))) {
+            inside.push_back(triangle);
+        }
+    }
+    if (dropped_count) {
+        *dropped_count = triangles.size() - inside.size();
     }
+
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    OctreeBuildContext ctx;
+    ctx.max_depth = octree.max_depth;
+    ctx.triangles_per_node = triangles_per_node;
+    ctx.looseness = looseness;
+    ctx.free_threads = thread_count - 1; // The calling thread works too
+
+    buildOctreeNode(octree.root.get(), std::move(inside), 0, ctx);
+    return octree;
 }
 
 void getTrianglesFromOctree(const OctreeNode* node, const AABB& query_bounds, std::vector<Triangle>& out_triangles) {
-    if (!node || !node->bounds.intersects(query_bounds)) {
+    if (!node || !node->loose_bounds.intersects(query_bounds)) {
         return;
     }
 
@@ -151,4 +353,159 @@ void getTrianglesFromOctree(const OctreeNode* node, const AABB& query_bounds, st
     }
 }
 
-} // namespace Collision
\ No newline at end of file
+
+// --- Linear Octree Functions ---
+
+// Records the triangle count of every subtree, bottom-up in one pass, so
+// empty children can be skipped; returns the count of the node's own
+size_t countSubtreeTriangles(const OctreeNode* node, std::unordered_map<const OctreeNode*, size_t>& counts) {
+    if (!node) return 0;
+    size_t count = node->triangles.size();
+    if (!node->is_leaf) {
+        for (int i = 0; i < 8; ++i) {
+            count += countSubtreeTriangles(node->children[i].get(), counts);
+        }
+    }
+    counts[node] = count;
+    return count;
+}
+
+LinearOctree flattenOctree(const Octree& octree) {
+    LinearOctree linear;
+    std::unordered_map<const OctreeNode*, size_t> subtree_triangles;
+    if (!octree.root || countSubtreeTriangles(octree.root.get(), subtree_triangles) == 0) {
+        return linear;
+    }
+
+    // Breadth-first walk; a node's children are appended together so they
+    // end up contiguous in the node array.
+    struct PendingNode {
+        const OctreeNode* node;
+        uint32_t index;
+        int depth;
+    };
+    std::queue<PendingNode> pending;
+
+    linear.nodes.push_back({octree.root->loose_bounds, 0, 0, 0, 0});
+    pending.push({octree.root.get(), 0, 0});
+
+    while (!pending.empty()) {
+        PendingNode current = pending.front();
+        pending.pop();
+        linear.depth = std::max(linear.depth, current.depth);
+
+        LinearOctreeNode& out = linear.nodes[current.index];
+        out.first_triangle = static_cast<uint32_t>(linear.triangles.size());
+        out.triangle_count = static_cast<uint32_t>(current.node->triangles.size());
+        linear.triangles.insert(linear.triangles.end(), current.node->triangles.begin(), current.node->triangles.end());
+
+        if (current.node->is_leaf) continue;
+
+        uint32_t first_child = static_cast<uint32_t>(linear.nodes.size());
+        uint32_t child_count = 0;
+        for (int i = 0; i < 8; ++i) {
+            const OctreeNode* child = current.node->children[i].get();
+            if (!child || subtree_triangles[child] == 0) continue;
+
+            uint32_t child_index = static_cast<uint32_t>(linear.nodes.size());
+            linear.nodes.push_back({child->loose_bounds, 0, 0, 0, 0});
+            pending.push({child, child_index, current.depth + 1});
+            ++child_count;
+        }
+        // Re-fetch: push_back above may have reallocated the node array
+        linear.nodes[current.index].first_child = first_child;
+        linear.nodes[current.index].child_count = child_count;
+    }
+    return linear;
+}
+
+LinearOctreeView getLinearOctreeView(const LinearOctree& octree) {
+    LinearOctreeView view;
+    view.nodes = octree.nodes.data();
+    view.node_count = static_cast<uint32_t>(octree.nodes.size());
+    view.triangles = octree.triangles.data();
+    view.triangle_count = static_cast<uint32_t>(octree.triangles.size());
+    return view;
+}
+
+void getTrianglesFromLinearOctree(const LinearOctree& octree, const AABB& query_bounds, std::vector<Triangle>& out_triangles) {
+    visitLinearOctree(octree, query_bounds, [&](const Triangle& triangle) {
+        out_triangles.push_back(triangle);
+        return true;
+    });
+}
+
+// --- Statistics ---
+
+void addCollisionQueryStats(CollisionQueryStats& total, const CollisionQueryStats& stats) {
+    total.queries += stats.queries;
+    total.nodes_visited += stats.nodes_visited;
+    total.triangles_returned += stats.triangles_returned;
+    total.triangles_hit += stats.triangles_hit;
+    total.field_answers += stats.field_answers;
+    total.cache_answers += stats.cache_answers;
+}
+
+void addOctreeStatsNode(OctreeStats& stats, int depth, uint32_t triangle_count, bool is_leaf) {
+    if (stats.nodes_per_depth.size() <= static_cast<size_t>(depth)) {
+        stats.nodes_per_depth.resize(depth + 1, 0);
+        stats.triangles_per_depth.resize(depth + 1, 0);
+    }
+    ++stats.node_count;
+    ++stats.nodes_per_depth[depth];
+    stats.triangles_per_depth[depth] += triangle_count;
+    stats.triangle_count += triangle_count;
+    stats.max_triangles_per_node = std::max(stats.max_triangles_per_node, triangle_count);
+    if (is_leaf) {
+        ++stats.leaf_count;
+    } else {
+        stats.interior_triangle_count += triangle_count;
+    }
+}
+
+void collectOctreeStats(const OctreeNode* node, int depth, OctreeStats& stats) {
+    if (!node) return;
+    addOctreeStatsNode(stats, depth, static_cast<uint32_t>(node->triangles.size()), node->is_leaf);
+    stats.memory_bytes += sizeof(OctreeNode) + node->triangles.capacity() * sizeof(Triangle);
+    for (int i = 0; i < 8; ++i) {
+        collectOctreeStats(node->children[i].get(), depth + 1, stats);
+    }
+}
+
+OctreeStats getOctreeStats(const Octree& octree) {
+    OctreeStats stats;
+    collectOctreeStats(octree.root.get(), 0, stats);
+    return stats;
+}
+
+OctreeStats getOctreeStats(const LinearOctreeView& octree) {
+    OctreeStats stats;
+    stats.memory_bytes = octree.node_count * sizeof(LinearOctreeNode);
+    if (octree.triangles) stats.memory_bytes += octree.triangle_count * sizeof(Triangle);
+    if (octree.node_count == 0) return stats;
+
+    // Breadth-first order means a node's children always come after it, so
+    // one forward pass can hand depths down
+    std::vector<int> depths(octree.node_count, 0);
+    for (uint32_t i = 0; i < octree.node_count; ++i) {
+        const LinearOctreeNode& node = octree.nodes[i];
+        addOctreeStatsNode(stats, depths[i], node.triangle_count, node.child_count == 0);
+        for (uint32_t c = 0; c < node.child_count; ++c) {
+            depths[node.first_child + c] = depths[i] + 1;
+        }
+    }
+    return stats;
+}
+
+void printOctreeStats(const OctreeStats& stats) {
+    std::cout << "Octree: " << stats.node_count << " nodes (" << stats.leaf_count << " leaves), "
+              << stats.triangle_count << " triangles (" << stats.interior_triangle_count << " at interior nodes), "
+              << "max " << stats.max_triangles_per_node << " per node, "
+              << stats.memory_bytes / 1024 << " KiB" << std::endl;
+    for (size_t depth = 0; depth < stats.nodes_per_depth.size(); ++depth) {
+        std::cout << "  depth " << depth << ": " << stats.nodes_per_depth[depth] << " nodes, "
+                  << stats.triangles_per_depth[depth] << " triangles" << std::endl;
+    }
+}
+
+} // namespace Collision
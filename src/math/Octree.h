@@ -2,6 +2,7 @@
 #define OCTREE_H
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <vector>
 #include <memory> // For std::unique_ptr
 
@@ -19,14 +20,70 @@ struct Triangle {
     glm::vec3 v0, v1, v2;
 };
 
+// AABB helpers shared by the acceleration structures
+AABB getTriangleAABB(const Triangle& triangle);
+AABB createEmptyAABB(); // Inverted box; expanding it by anything yields that thing
+void expandAABB(AABB& box, const AABB& other);
+float getAABBHalfArea(const AABB& box); // Half surface area, 0 for empty boxes
+AABB transformAABB(const AABB& box, const glm::mat4& transform); // Box around the transformed box
+AABB growAABB(const AABB& box, float margin); // By `margin` on every side
+bool containsAABB(const AABB& outer, const AABB& inner);
+
+// Ray prepared for slab tests. Points along it are origin + direction * t;
+// direction need not be normalized (a segment is direction = end - start,
+// t in [0, 1]).
+struct CollisionRay {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 inv_direction; // Huge but finite for zero components
+};
+
+CollisionRay createCollisionRay(const glm::vec3& origin, const glm::vec3& direction);
+
+// Slab test against `box` grown by `expand` on every side (the sphere radius
+// for sweeps). On overlap within [0, max_t], t_enter is where the ray enters
+// the box, or 0 if it starts inside.
+inline bool intersectRayAABB(const CollisionRay& ray, const AABB& box, float expand, float max_t, float& t_enter) {
+    float t_min = 0.0f;
+    float t_max = max_t;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (box.min[axis] - expand - ray.origin[axis]) * ray.inv_direction[axis];
+        float t1 = (box.max[axis] + expand - ray.origin[axis]) * ray.inv_direction[axis];
+        if (t0 > t1) {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_min > t_max) return false;
+    }
+    t_enter = t_min;
+    return true;
+}
+
+// Per-query work counters. Queries take an optional pointer and add to it,
+// so one instance can total a frame's worth of queries.
+struct CollisionQueryStats {
+    uint64_t queries = 0;
+    uint64_t nodes_visited = 0;      // Nodes whose bounds were tested
+    uint64_t triangles_returned = 0; // Candidates handed to the narrow phase
+    uint64_t triangles_hit = 0;      // Candidates the narrow phase accepted
+    uint64_t field_answers = 0;      // Queries answered by a baked distance field instead
+    uint64_t cache_answers = 0;      // Queries answered from a ContactCache without a traversal
+};
+
+void addCollisionQueryStats(CollisionQueryStats& total, const CollisionQueryStats& stats);
+
 // Forward declaration of OctreeNode for use in Octree struct
 struct OctreeNode;
 
 // Free functions for OctreeNode operations
-void initOctreeNode(OctreeNode* node, const AABB& bounds);
+void initOctreeNode(OctreeNode* node, const AABB& bounds, float looseness = 1.0f);
 
 struct OctreeNode {
-    AABB bounds;
+    AABB bounds;       // The node's cell; children split it into octants
+    AABB loose_bounds; // Cell grown by the octree's looseness; what it may hold
     std::unique_ptr<OctreeNode> children[8]; // Unique pointers for ownership
     std::vector<Triangle> triangles;
     bool is_leaf; // Flag to indicate if node has children
@@ -37,13 +94,215 @@ struct Octree {
     std::unique_ptr<OctreeNode> root;
     int max_depth; // Max subdivision depth
     int triangles_per_node; // Max triangles before subdivision
+    // Loose octree factor: child cells accept triangles within
+    // `looseness` times their size (1 = classic tight octree, 2 = typical
+    // loose octree). Lets straddling triangles sink below the parent.
+    float looseness = 1.0f;
 };
 
+// Deepest subdivision the linear traversal stacks hold (see
+// LINEAR_OCTREE_STACK_SIZE); deeper max_depth settings are clamped to it
+const int OCTREE_MAX_BUILD_DEPTH = 31;
+
 // Free functions for Octree operations
-Octree createOctree(const AABB& bounds, int max_depth = 8, int triangles_per_node = 8);
-void insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node);
+Octree createOctree(const AABB& bounds, int max_depth = 8, int triangles_per_node = 8, float looseness = 1.0f);
+// Cubic root bounds enclosing every triangle, so no triangle gets dropped
+AABB computeOctreeBounds(const std::vector<Triangle>& triangles);
+// Returns false if the triangle lies outside the node and was dropped
+bool insertTriangleIntoOctree(OctreeNode* node, const Triangle& triangle, int current_depth, int max_depth, int triangles_per_node, float looseness = 1.0f);
+// Bulk build: partitions the whole triangle set top-down and builds large
+// subtrees on worker threads. Produces the same tree as inserting the
+// triangles one by one with insertTriangleIntoOctree, in the same order.
+// thread_count <= 0 uses every hardware thread. Triangles outside `bounds`
+// are dropped and counted in *dropped_count if given.
+Octree buildOctree(const std::vector<Triangle>& triangles, const AABB& bounds, int max_depth, int triangles_per_node,
+                   float looseness = 1.0f, int thread_count = 0, size_t* dropped_count = nullptr);
 void getTrianglesFromOctree(const OctreeNode* node, const AABB& query_bounds, std::vector<Triangle>& out_triangles);
 
+// --- Linearized (frozen) Octree ---
+// A pointer-free copy of a built Octree, used for the per-frame queries.
+// Nodes are stored breadth-first in one array: the children of a node are
+// contiguous starting at `first_child`, and empty subtrees are dropped.
+// Every node's triangles are a contiguous range of the packed `triangles`
+// array, so a query only ever walks two flat buffers.
+struct LinearOctreeNode {
+    AABB bounds;
+    uint32_t first_child;    // Index of the first child in LinearOctree::nodes
+    uint32_t first_triangle; // Index of the first triangle in LinearOctree::triangles
+    uint32_t triangle_count; // Triangles stored directly at this node
+    uint32_t child_count;    // Number of (non-empty) children
+};
+
+// Traversal stack size; a query pushes at most 7 siblings per level, so this
+// holds any tree up to OCTREE_MAX_BUILD_DEPTH
+const int LINEAR_OCTREE_STACK_SIZE = 256;
+
+struct LinearOctree {
+    std::vector<LinearOctreeNode> nodes; // nodes[0] is the root (empty if no triangles)
+    std::vector<Triangle> triangles;     // Packed per node, in node order
+    int depth = 0;                       // Deepest level present in the tree
+};
+
+// Non-owning view of a LinearOctree's arrays. Queries run on views, so the
+// data can live in a LinearOctree or in a memory-mapped cache file.
+struct LinearOctreeView {
+    const LinearOctreeNode* nodes = nullptr;
+    uint32_t node_count = 0;
+    const Triangle* triangles = nullptr;
+    uint32_t triangle_count = 0;
+};
+
+// Shape of a built tree, for tuning max_depth / triangles_per_node
+struct OctreeStats {
+    uint32_t node_count = 0;
+    uint32_t leaf_count = 0;
+    uint32_t triangle_count = 0;
+    uint32_t interior_triangle_count = 0; // Held at nodes with children
+    uint32_t max_triangles_per_node = 0;
+    std::vector<uint32_t> nodes_per_depth;     // [d] = nodes at depth d (root is 0)
+    std::vector<uint32_t> triangles_per_depth; // [d] = triangles held at depth d
+    size_t memory_bytes = 0;                   // Nodes plus triangle storage
+};
+
+OctreeStats getOctreeStats(const Octree& octree);
+OctreeStats getOctreeStats(const LinearOctreeView& octree);
+void printOctreeStats(const OctreeStats& stats);
+
+// Flattens a built Octree. The source tree can be discarded afterwards.
+LinearOctree flattenOctree(const Octree& octree);
+LinearOctreeView getLinearOctreeView(const LinearOctree& octree);
+void getTrianglesFromLinearOctree(const LinearOctree& octree, const AABB& query_bounds, std::vector<Triangle>& out_triangles);
+
+// --- Visitor Queries ---
+// Zero-copy alternatives to getTrianglesFromLinearOctree. The visitor is
+// called for every candidate triangle of every node overlapping query_bounds
+// and returns true to continue or false to stop the query early.
+// Both return false if the visitor stopped the query. No heap allocation.
+// With `stats`, the traversal counts visited nodes and returned triangles.
+
+// visitor(const LinearOctreeNode& node) -> bool, for every overlapping node.
+// Lets batched narrow phases work on a node's whole triangle range at once.
+template <typename Visitor>
+bool visitLinearOctreeNodes(const LinearOctreeView& octree, const AABB& query_bounds, Visitor&& visitor,
+                            CollisionQueryStats* stats = nullptr) {
+    if (octree.node_count == 0) return true;
+
+    uint32_t stack[LINEAR_OCTREE_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const LinearOctreeNode& node = octree.nodes[stack[--stack_size]];
+        if (stats) ++stats->nodes_visited;
+        if (!node.bounds.intersects(query_bounds)) continue;
+
+        if (node.triangle_count > 0) {
+            if (stats) stats->triangles_returned += node.triangle_count;
+            if (!visitor(node)) return false;
+        }
+
+        for (uint32_t i = 0; i < node.child_count; ++i) {
+            stack[stack_size++] = node.first_child + i;
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool visitLinearOctreeNodes(const LinearOctree& octree, const AABB& query_bounds, Visitor&& visitor,
+                            CollisionQueryStats* stats = nullptr) {
+    return visitLinearOctreeNodes(getLinearOctreeView(octree), query_bounds, visitor, stats);
+}
+
+// visitor(uint32_t triangle_index) -> bool, index into octree.triangles
+template <typename Visitor>
+bool visitLinearOctreeIndices(const LinearOctreeView& octree, const AABB& query_bounds, Visitor&& visitor) {
+    return visitLinearOctreeNodes(octree, query_bounds, [&](const LinearOctreeNode& node) {
+        uint32_t end = node.first_triangle + node.triangle_count;
+        for (uint32_t i = node.first_triangle; i < end; ++i) {
+            if (!visitor(i)) return false;
+        }
+        return true;
+    });
+}
+
+template <typename Visitor>
+bool visitLinearOctreeIndices(const LinearOctree& octree, const AABB& query_bounds, Visitor&& visitor) {
+    return visitLinearOctreeIndices(getLinearOctreeView(octree), query_bounds, visitor);
+}
+
+// visitor(const Triangle& triangle) -> bool
+template <typename Visitor>
+bool visitLinearOctree(const LinearOctreeView& octree, const AABB& query_bounds, Visitor&& visitor) {
+    const Triangle* triangles = octree.triangles;
+    return visitLinearOctreeIndices(octree, query_bounds, [&](uint32_t index) {
+        return visitor(triangles[index]);
+    });
+}
+
+template <typename Visitor>
+bool visitLinearOctree(const LinearOctree& octree, const AABB& query_bounds, Visitor&& visitor) {
+    return visitLinearOctree(getLinearOctreeView(octree), query_bounds, visitor);
+}
+
+// --- Ordered Ray Traversal ---
+// visitor(const LinearOctreeNode& node, float& max_t) -> bool, for every
+// node holding triangles whose bounds (grown by `expand`) the ray enters
+// within [0, max_t]. Children are visited nearest entry first. The visitor
+// lowers max_t when it finds a hit, which prunes every node entered later
+// (closest hit), or returns false to stop (any hit).
+template <typename Visitor>
+bool visitLinearOctreeRay(const LinearOctreeView& octree, const CollisionRay& ray, float expand, float max_t,
+                          Visitor&& visitor, CollisionQueryStats* stats = nullptr) {
+    struct Entry {
+        uint32_t node;
+        float t;
+    };
+    float t;
+    if (octree.node_count == 0) return true;
+    if (stats) ++stats->nodes_visited;
+    if (!intersectRayAABB(ray, octree.nodes[0].bounds, expand, max_t, t)) return true;
+
+    Entry stack[LINEAR_OCTREE_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = {0, t};
+
+    while (stack_size > 0) {
+        Entry entry = stack[--stack_size];
+        if (entry.t > max_t) continue; // A closer hit turned up after the push
+
+        const LinearOctreeNode& node = octree.nodes[entry.node];
+        if (node.triangle_count > 0) {
+            if (stats) stats->triangles_returned += node.triangle_count;
+            if (!visitor(node, max_t)) return false;
+        }
+
+        // Sort the hit children far to near so the nearest is popped first
+        Entry children[8];
+        int child_hits = 0;
+        if (stats) stats->nodes_visited += node.child_count;
+        for (uint32_t i = 0; i < node.child_count; ++i) {
+            uint32_t child = node.first_child + i;
+            if (!intersectRayAABB(ray, octree.nodes[child].bounds, expand, max_t, t)) continue;
+            int j = child_hits++;
+            for (; j > 0 && children[j - 1].t < t; --j) {
+                children[j] = children[j - 1];
+            }
+            children[j] = {child, t};
+        }
+        for (int i = 0; i < child_hits; ++i) {
+            stack[stack_size++] = children[i];
+        }
+    }
+    return true;
+}
+
+template <typename Visitor>
+bool visitLinearOctreeRay(const LinearOctree& octree, const CollisionRay& ray, float expand, float max_t,
+                          Visitor&& visitor, CollisionQueryStats* stats = nullptr) {
+    return visitLinearOctreeRay(getLinearOctreeView(octree), ray, expand, max_t, visitor, stats);
+}
+
 // Helper functions for triangle-octant relationship
 bool isTriangleWhollyContainedInAABB(const AABB& aabb, const Triangle& triangle);
 int getContainingOctant(const OctreeNode* node, const Triangle& triangle);
@@ -0,0 +1,65 @@
+#ifndef PLAYER_COLLISION_H
+#define PLAYER_COLLISION_H
+
+#include "CollisionWorld.h"
+#include "../config.h"
+#include <glm/glm.hpp>
+
+namespace Collision {
+
+// The player's collision for one simulation tick, in the order and with the
+// reactions stepSimulation uses. collision-bench's synthetic walk runs the
+// same function, so its queries can't drift from the game's.
+// position is the player's feet; its sphere sits Config::PLAYER_RADIUS above
+// them. The caller runs the queries on whatever structure it has:
+//   contact(center, radius, normal, depth) -> bool   (findDeepestSphereContact)
+//   sweep(center, radius, motion, filter, hit) -> bool   (castCollisionSphere)
+template <typename ContactQuery, typename SweepQuery>
+void stepPlayerCollision(glm::vec3& position, float& y_velocity, bool& is_grounded, float delta_time,
+                         ContactQuery&& contact, SweepQuery&& sweep) {
+    const glm::vec3 sphere_offset(0.0f, Config::PLAYER_RADIUS, 0.0f);
+    is_grounded = false;
+
+    // Push out of anything the player was walked into after last tick's
+    // physics first, so the fall starts clear of the walls
+    glm::vec3 normal(0.0f);
+    float depth = 0.0f;
+    if (contact(position + sphere_offset, Config::PLAYER_RADIUS, normal, depth)) {
+        position += normal * depth;
+        if (normal.y > 0.5f) {
+            y_velocity = 0.0f;
+            is_grounded = true;
+        } else if (normal.y < 0.1f && normal.y * y_velocity < 0.0f) {
+            y_velocity = 0.0f;
+        }
+    }
+
+    y_velocity -= Config::GRAVITY_STRENGTH * delta_time;
+
+    // Sweep the fall instead of teleporting by it, so a long tick can't carry
+    // the sphere through a thin floor. Stops at the time of impact, backed
+    // off a hair so the next sweep starts clear. Only surfaces facing against
+    // the fall stop it: a wall the sphere runs along (or still touches)
+    // doesn't.
+    glm::vec3 motion(0.0f, y_velocity * delta_time, 0.0f);
+    CollisionHit impact;
+    if (sweep(position + sphere_offset, Config::PLAYER_RADIUS, motion, CastFilter::Opposing, impact)) {
+        float travel = glm::length(motion) * impact.t;
+        if (travel > Config::PLAYER_CONTACT_SKIN) {
+            position += motion * (impact.t * (1.0f - Config::PLAYER_CONTACT_SKIN / travel));
+        }
+        if (impact.normal.y > 0.5f) {
+            y_velocity = 0.0f;
+            is_grounded = true;
+        } else if (impact.normal.y * motion.y < 0.0f) {
+            // A ceiling on the way up, or a slope too steep to stand on
+            y_velocity = 0.0f;
+        }
+    } else {
+        position += motion;
+    }
+}
+
+} // namespace Collision
+
+#endif // PLAYER_COLLISION_H
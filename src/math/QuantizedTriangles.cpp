@@ -0,0 +1,116 @@
+#include "QuantizedTriangles.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace Collision {
+
+const float QUANTIZED_MAX_COORDINATE = 65535.0f;
+
+QuantizedVertex quantizeVertex(const glm::vec3& position, const glm::vec3& origin, const glm::vec3& inv_step) {
+    glm::vec3 q = glm::clamp(glm::floor((position - origin) * inv_step + 0.5f), glm::vec3(0.0f),
+                             glm::vec3(QUANTIZED_MAX_COORDINATE));
+    return {static_cast<uint16_t>(q.x), static_cast<uint16_t>(q.y), static_cast<uint16_t>(q.z)};
+}
+
+uint64_t getQuantizedVertexKey(const QuantizedVertex& vertex) {
+    return static_cast<uint64_t>(vertex.x) | static_cast<uint64_t>(vertex.y) << 16 |
+           static_cast<uint64_t>(vertex.z) << 32;
+}
+
+QuantizedTriangles quantizeTriangles(const Triangle* triangles, uint32_t count, std::vector<uint32_t> range_starts) {
+    QuantizedTriangles quantized;
+    if (count == 0) return quantized;
+
+    range_starts.push_back(0);
+    std::sort(range_starts.begin(), range_starts.end());
+    range_starts.erase(std::unique(range_starts.begin(), range_starts.end()), range_starts.end());
+    while (!range_starts.empty() && range_starts.back() >= count) range_starts.pop_back();
+
+    quantized.triangles.resize(count);
+    quantized.blocks.reserve(range_starts.size());
+    std::unordered_map<uint64_t, uint16_t> block_vertices;
+
+    for (size_t r = 0; r < range_starts.size(); ++r) {
+        uint32_t first = range_starts[r];
+        uint32_t end = r + 1 < range_starts.size() ? range_starts[r + 1] : count;
+
+        AABB bounds = createEmptyAABB();
+        for (uint32_t i = first; i < end; ++i) {
+            expandAABB(bounds, getTriangleAABB(triangles[i]));
+        }
+        glm::vec3 step = (bounds.max - bounds.min) / QUANTIZED_MAX_COORDINATE;
+        glm::vec3 inv_step(step.x > 0.0f ? 1.0f / step.x : 0.0f, step.y > 0.0f ? 1.0f / step.y : 0.0f,
+                           step.z > 0.0f ? 1.0f / step.z : 0.0f);
+
+        for (uint32_t i = first; i < end; ++i) {
+            // A new block (same bounds) whenever the next triangle could
+            // overflow the 16-bit vertex indices
+            if (i == first || block_vertices.size() + 3 > QUANTIZED_MAX_BLOCK_VERTICES) {
+                QuantizedTriangleBlock block;
+                block.origin = bounds.min;
+                block.step = step;
+                block.first_triangle = i;
+                block.first_vertex = static_cast<uint32_t>(quantized.vertices.size());
+                quantized.blocks.push_back(block);
+                block_vertices.clear();
+            }
+            uint32_t first_vertex = quantized.blocks.back().first_vertex;
+
+            const glm::vec3 corners[3] = {triangles[i].v0, triangles[i].v1, triangles[i].v2};
+            for (int c = 0; c < 3; ++c) {
+                QuantizedVertex vertex = quantizeVertex(corners[c], bounds.min, inv_step);
+                auto inserted = block_vertices.emplace(
+                    getQuantizedVertexKey(vertex),
+                    static_cast<uint16_t>(quantized.vertices.size() - first_vertex));
+                if (inserted.second) quantized.vertices.push_back(vertex);
+                quantized.triangles[i].v[c] = inserted.first->second;
+            }
+        }
+    }
+    return quantized;
+}
+
+QuantizedTrianglesView getQuantizedTrianglesView(const QuantizedTriangles& quantized) {
+    QuantizedTrianglesView view;
+    view.blocks = quantized.blocks.data();
+    view.block_count = static_cast<uint32_t>(quantized.blocks.size());
+    view.vertices = quantized.vertices.data();
+    view.vertex_count = static_cast<uint32_t>(quantized.vertices.size());
+    view.triangles = quantized.triangles.data();
+    view.triangle_count = static_cast<uint32_t>(quantized.triangles.size());
+    return view;
+}
+
+size_t getQuantizedTrianglesBytes(const QuantizedTrianglesView& quantized) {
+    return quantized.block_count * sizeof(QuantizedTriangleBlock) +
+           quantized.vertex_count * sizeof(QuantizedVertex) +
+           quantized.triangle_count * sizeof(QuantizedTriangle);
+}
+
+uint32_t findQuantizedBlock(const QuantizedTrianglesView& quantized, uint32_t index) {
+    // Last block starting at or before `index`; block 0 starts at 0
+    uint32_t low = 0;
+    uint32_t high = quantized.block_count;
+    while (high - low > 1) {
+        uint32_t mid = (low + high) / 2;
+        if (quantized.blocks[mid].first_triangle <= index) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void decodeQuantizedTriangles(const QuantizedTrianglesView& quantized, uint32_t first, uint32_t count,
+                              Triangle* out) {
+    if (count == 0) return;
+    uint32_t block = findQuantizedBlock(quantized, first);
+    for (uint32_t i = first; i < first + count; ++i) {
+        while (block + 1 < quantized.block_count && quantized.blocks[block + 1].first_triangle <= i) ++block;
+        out[i - first] = decodeQuantizedTriangle(quantized, block, i);
+    }
+}
+
+} // namespace Collision
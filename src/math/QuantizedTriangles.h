@@ -0,0 +1,87 @@
+#ifndef QUANTIZED_TRIANGLES_H
+#define QUANTIZED_TRIANGLES_H
+
+#include "Octree.h" // For AABB, Triangle
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Collision {
+
+// Compact copy of a structure's packed triangle array. The array is cut into
+// blocks along the structure's own ranges (octree nodes, BVH leaves), and each
+// block quantizes its vertices to 16 bits per axis over the bounds of its
+// triangles. Vertices a block's triangles share are stored once, and
+// triangles are three 16-bit indices into their block's vertices, so a
+// triangle costs about 6 bytes plus its share of the vertices, against 36 for
+// a Triangle and 96 for its SoA record.
+// Decoding is exact to within half a step (the block's extent / 65535) per
+// axis. Neighbouring blocks quantize a shared vertex separately, so a mesh
+// that was closed can open cracks of that size between blocks.
+
+const uint32_t QUANTIZED_MAX_BLOCK_VERTICES = 65536; // Indices are 16 bits
+
+struct QuantizedTriangleBlock {
+    glm::vec3 origin;        // Position of quantized (0, 0, 0)
+    glm::vec3 step;          // Size of one quantization step, per axis
+    uint32_t first_triangle; // Runs up to the next block's first_triangle
+    uint32_t first_vertex;   // Vertex indices of the block's triangles start here
+};
+
+struct QuantizedVertex {
+    uint16_t x, y, z;
+};
+
+struct QuantizedTriangle {
+    uint16_t v[3]; // Relative to the block's first_vertex
+};
+
+struct QuantizedTriangles {
+    std::vector<QuantizedTriangleBlock> blocks;
+    std::vector<QuantizedVertex> vertices;
+    std::vector<QuantizedTriangle> triangles;
+};
+
+// Non-owning view (see LinearOctreeView); blocks are sorted by first_triangle
+struct QuantizedTrianglesView {
+    const QuantizedTriangleBlock* blocks = nullptr;
+    uint32_t block_count = 0;
+    const QuantizedVertex* vertices = nullptr;
+    uint32_t vertex_count = 0;
+    const QuantizedTriangle* triangles = nullptr;
+    uint32_t triangle_count = 0;
+};
+
+// range_starts: first triangle of every range the structure hands out, in
+// any order. A block never spans two ranges, so each range decodes relative
+// to the bounds of its own triangles.
+QuantizedTriangles quantizeTriangles(const Triangle* triangles, uint32_t count,
+                                     std::vector<uint32_t> range_starts);
+QuantizedTrianglesView getQuantizedTrianglesView(const QuantizedTriangles& quantized);
+size_t getQuantizedTrianglesBytes(const QuantizedTrianglesView& quantized);
+
+// Block holding triangle `index`, by binary search
+uint32_t findQuantizedBlock(const QuantizedTrianglesView& quantized, uint32_t index);
+
+inline glm::vec3 decodeQuantizedVertex(const QuantizedTriangleBlock& block, const QuantizedVertex& vertex) {
+    return block.origin + glm::vec3(vertex.x, vertex.y, vertex.z) * block.step;
+}
+
+inline Triangle decodeQuantizedTriangle(const QuantizedTrianglesView& quantized, uint32_t block_index,
+                                        uint32_t index) {
+    const QuantizedTriangleBlock& block = quantized.blocks[block_index];
+    const QuantizedTriangle& triangle = quantized.triangles[index];
+    const QuantizedVertex* vertices = quantized.vertices + block.first_vertex;
+    return {decodeQuantizedVertex(block, vertices[triangle.v[0]]),
+            decodeQuantizedVertex(block, vertices[triangle.v[1]]),
+            decodeQuantizedVertex(block, vertices[triangle.v[2]])};
+}
+
+// Decodes triangles [first, first + count) into out, finding the first block
+// once and stepping through the rest
+void decodeQuantizedTriangles(const QuantizedTrianglesView& quantized, uint32_t first, uint32_t count,
+                              Triangle* out);
+
+} // namespace Collision
+
+#endif // QUANTIZED_TRIANGLES_H
@@ -0,0 +1,216 @@
+#include "TriangleBatch.h"
+#include "GeometryUtils.h"
+#include "TriangleBatchKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define TRIANGLE_BATCH_X86 1
+#include <emmintrin.h> // SSE2 is part of the x86-64 baseline
+#endif
+
+// Implemented in TriangleBatchAvx2.cpp (built with AVX2 enabled)
+bool isAvx2TriangleKernelAvailable();
+int64_t findDeepestCandidateAvx2(const float* data, uint32_t stride, uint32_t begin, uint32_t end,
+                                 float center_x, float center_y, float center_z,
+                                 float radius, float max_depth, uint32_t& hit_count);
+
+static_assert(MathUtils::TRIANGLE_SOA_COMPONENTS == SOA_COMPONENT_COUNT,
+              "SoA layout differs between TriangleBatch.h and TriangleBatchKernel.h");
+
+namespace {
+
+#ifdef TRIANGLE_BATCH_X86
+struct SseOps {
+    typedef __m128 V;
+    static const int WIDTH = 4;
+
+    static V set1(float f) { return _mm_set1_ps(f); }
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V laneOffsets() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+    // Integer lanes, carried in V by bit pattern: first, first + 1, ...
+    static V indices(uint32_t first) {
+        return _mm_castsi128_ps(_mm_add_epi32(_mm_set1_epi32(static_cast<int>(first)), _mm_setr_epi32(0, 1, 2, 3)));
+    }
+    static V noIndex() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    // Integer counts plus one in the lanes set in mask (a set mask lane is -1)
+    static V countMask(V counts, V mask) {
+        return _mm_castsi128_ps(_mm_sub_epi32(_mm_castps_si128(counts), _mm_castps_si128(mask)));
+    }
+    static void storeIntegers(uint32_t* p, V v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_castps_si128(v));
+    }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static V cmplt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static V cmple(V a, V b) { return _mm_cmple_ps(a, b); }
+    static V cmpgt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V cmpge(V a, V b) { return _mm_cmpge_ps(a, b); }
+    static V andMask(V a, V b) { return _mm_and_ps(a, b); }
+    static bool anyMask(V mask) { return _mm_movemask_ps(mask) != 0; }
+    // mask ? a : b
+    static V select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    // Operand order makes NaN propagate like glm::clamp (degenerate edges)
+    static V clamp01(V a) { return _mm_min_ps(_mm_set1_ps(1.0f), _mm_max_ps(_mm_setzero_ps(), a)); }
+    static V dot(V ax, V ay, V az, V bx, V by, V bz) {
+        return add(add(mul(ax, bx), mul(ay, by)), mul(az, bz));
+    }
+};
+#endif
+
+MathUtils::SimdLevel detectSimdLevel() {
+#ifdef TRIANGLE_BATCH_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (isAvx2TriangleKernelAvailable() && __builtin_cpu_supports("avx2")) {
+        return MathUtils::SimdLevel::AVX2;
+    }
+#endif
+    return MathUtils::SimdLevel::SSE;
+#else
+    return MathUtils::SimdLevel::Scalar;
+#endif
+}
+
+// Scalar fallback: the per-triangle record test
+int64_t findDeepestCandidateScalar(const MathUtils::TriangleSoAView& soa, uint32_t begin, uint32_t end,
+                                   const glm::vec3& sphere_center, float sphere_radius, float max_depth,
+                                   uint32_t& hit_count) {
+    int64_t result = -1;
+    for (uint32_t i = begin; i < end; ++i) {
+        glm::vec3 normal;
+        float depth;
+        if (!MathUtils::checkSphereTriangleRecord(sphere_center, sphere_radius,
+                                                  MathUtils::getSoATriangleRecord(soa, i), normal, depth)) {
+            continue;
+        }
+        ++hit_count;
+        if (depth > max_depth) {
+            max_depth = depth;
+            result = i;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+namespace MathUtils {
+
+TriangleSoA createTriangleSoA(const Collision::Triangle* triangles, uint32_t count) {
+    TriangleSoA soa;
+    soa.count = count;
+    // Round up to a whole 8-wide block, plus one block of slack for loads
+    // that start near the end of the array
+    soa.stride = ((soa.count + 7) / 8) * 8 + 8;
+    soa.data.assign(static_cast<size_t>(soa.stride) * TRIANGLE_SOA_COMPONENTS, 0.0f);
+
+    for (uint32_t i = 0; i < soa.count; ++i) {
+        setSoATriangleRecord(soa.data.data(), soa.stride, i, createTriangleRecord(triangles[i]));
+    }
+    return soa;
+}
+
+void setSoATriangleRecord(float* data, uint32_t stride, uint32_t index, const TriangleRecord& record) {
+    const float components[SOA_COMPONENT_COUNT] = {
+        record.a.x, record.a.y, record.a.z,
+        record.ab.x, record.ab.y, record.ab.z,
+        record.ac.x, record.ac.y, record.ac.z,
+        record.normal.x, record.normal.y, record.normal.z,
+        record.ab_ab, record.ab_ac, record.ac_ac,
+        record.inv_ab_ab, record.inv_ac_ac, record.inv_bc_bc,
+        record.bounds.min.x, record.bounds.min.y, record.bounds.min.z,
+        record.bounds.max.x, record.bounds.max.y, record.bounds.max.z};
+    for (int c = 0; c < SOA_COMPONENT_COUNT; ++c) {
+        data[c * stride + index] = components[c];
+    }
+}
+
+TriangleSoA createTriangleSoA(const std::vector<Collision::Triangle>& triangles) {
+    return createTriangleSoA(triangles.data(), static_cast<uint32_t>(triangles.size()));
+}
+
+TriangleSoAView getTriangleSoAView(const TriangleSoA& soa) {
+    TriangleSoAView view;
+    view.data = soa.data.data();
+    view.count = soa.count;
+    view.stride = soa.stride;
+    return view;
+}
+
+TriangleRecord getSoATriangleRecord(const TriangleSoAView& soa, uint32_t index) {
+    const float* p = soa.data + index;
+    const uint32_t s = soa.stride;
+    TriangleRecord record;
+    record.a = glm::vec3(p[SOA_A_X * s], p[SOA_A_Y * s], p[SOA_A_Z * s]);
+    record.ab = glm::vec3(p[SOA_AB_X * s], p[SOA_AB_Y * s], p[SOA_AB_Z * s]);
+    record.ac = glm::vec3(p[SOA_AC_X * s], p[SOA_AC_Y * s], p[SOA_AC_Z * s]);
+    record.normal = glm::vec3(p[SOA_N_X * s], p[SOA_N_Y * s], p[SOA_N_Z * s]);
+    record.ab_ab = p[SOA_AB_AB * s];
+    record.ab_ac = p[SOA_AB_AC * s];
+    record.ac_ac = p[SOA_AC_AC * s];
+    record.inv_ab_ab = p[SOA_INV_AB_AB * s];
+    record.inv_ac_ac = p[SOA_INV_AC_AC * s];
+    record.inv_bc_bc = p[SOA_INV_BC_BC * s];
+    record.bounds.min = glm::vec3(p[SOA_MIN_X * s], p[SOA_MIN_Y * s], p[SOA_MIN_Z * s]);
+    record.bounds.max = glm::vec3(p[SOA_MAX_X * s], p[SOA_MAX_Y * s], p[SOA_MAX_Z * s]);
+    return record;
+}
+
+SimdLevel getSimdLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::SSE: return "SSE";
+    default: return "Scalar";
+    }
+}
+
+bool findDeepestSphereContact(const TriangleSoAView& soa, uint32_t begin, uint32_t end,
+                              const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& max_depth, uint32_t* hit_count) {
+    if (begin >= end) return false;
+
+    int64_t candidate = -1;
+    uint32_t hits = 0;
+    switch (getSimdLevel()) {
+#ifdef TRIANGLE_BATCH_X86
+    case SimdLevel::AVX2:
+        candidate = findDeepestCandidateAvx2(soa.data, soa.stride, begin, end,
+                                             sphere_center.x, sphere_center.y, sphere_center.z,
+                                             sphere_radius, max_depth, hits);
+        break;
+    case SimdLevel::SSE:
+        candidate = findDeepestCandidate<SseOps>(soa.data, soa.stride, begin, end,
+                                                 sphere_center.x, sphere_center.y, sphere_center.z,
+                                                 sphere_radius, max_depth, hits);
+        break;
+#endif
+    default:
+        candidate = findDeepestCandidateScalar(soa, begin, end, sphere_center, sphere_radius, max_depth, hits);
+        break;
+    }
+    if (hit_count) *hit_count += hits;
+    if (candidate < 0) return false;
+
+    // Only the winner pays for the normal. Re-running the scalar test keeps
+    // the reported normal/depth identical to the per-triangle path.
+    glm::vec3 normal;
+    float depth;
+    if (!checkSphereTriangleRecord(sphere_center, sphere_radius,
+                                   getSoATriangleRecord(soa, static_cast<uint32_t>(candidate)), normal, depth) ||
+        depth <= max_depth) {
+        return false;
+    }
+    collision_normal = normal;
+    max_depth = depth;
+    return true;
+}
+
+} // namespace MathUtils
@@ -0,0 +1,60 @@
+#ifndef TRIANGLE_BATCH_H
+#define TRIANGLE_BATCH_H
+
+#include "GeometryUtils.h" // For TriangleRecord
+#include "Octree.h"        // For Collision::Triangle
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace MathUtils {
+
+// Number of floats stored per triangle: one per TriangleRecord component
+const uint32_t TRIANGLE_SOA_COMPONENTS = 24;
+
+// Structure-of-arrays copy of a triangle list's TriangleRecords for the
+// batched narrow phase. Component c (a.x, a.y, a.z, ab.x, ... bounds.max.z,
+// in TriangleRecord field order) of triangle i lives at
+// data[c * stride + i]. The stride is padded so a full 8-wide load starting
+// at any valid triangle stays inside the buffer.
+struct TriangleSoA {
+    std::vector<float> data;
+    uint32_t count = 0;
+    uint32_t stride = 0;
+};
+
+// Non-owning view of SoA triangle data, e.g. inside a mapped cache file
+struct TriangleSoAView {
+    const float* data = nullptr;
+    uint32_t count = 0;
+    uint32_t stride = 0;
+};
+
+// Widest narrow-phase kernel usable on this CPU, picked once at runtime
+enum class SimdLevel { Scalar, SSE, AVX2 };
+
+// Triangle order is preserved, so octree node ranges index the SoA directly
+TriangleSoA createTriangleSoA(const Collision::Triangle* triangles, uint32_t count);
+TriangleSoA createTriangleSoA(const std::vector<Collision::Triangle>& triangles);
+TriangleSoAView getTriangleSoAView(const TriangleSoA& soa);
+TriangleRecord getSoATriangleRecord(const TriangleSoAView& soa, uint32_t index);
+// Writes slot `index` of a caller-owned SoA buffer (stride * TRIANGLE_SOA_COMPONENTS floats)
+void setSoATriangleRecord(float* data, uint32_t stride, uint32_t index, const TriangleRecord& record);
+
+SimdLevel getSimdLevel();
+const char* getSimdLevelName(SimdLevel level);
+
+// Tests one sphere against triangles [begin, end) of the SoA, 4 or 8 at a
+// time. Same results as checkSphereTriangleRecord per triangle, and follows
+// the same rule as the scalar loop: a contact replaces the
+// current one only if it is strictly deeper than max_depth, so on ties the
+// earliest triangle wins. Updates collision_normal/max_depth and returns true
+// if a deeper contact was found. Adds the number of triangles touching the
+// sphere (deeper or not) to *hit_count if given.
+bool findDeepestSphereContact(const TriangleSoAView& soa, uint32_t begin, uint32_t end,
+                              const glm::vec3& sphere_center, float sphere_radius,
+                              glm::vec3& collision_normal, float& max_depth, uint32_t* hit_count = nullptr);
+
+} // namespace MathUtils
+
+#endif
@@ -0,0 +1,74 @@
+// 8-wide narrow-phase kernel. This file is compiled with AVX2 enabled (see
+// CMakeLists.txt) and only called after a runtime CPU check, so it must not
+// include glm or anything else with inline code shared with other files.
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include "TriangleBatchKernel.h"
+
+namespace {
+
+struct Avx2Ops {
+    typedef __m256 V;
+    static const int WIDTH = 8;
+
+    static V set1(float f) { return _mm256_set1_ps(f); }
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V laneOffsets() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+    // Integer lanes, carried in V by bit pattern: first, first + 1, ...
+    static V indices(uint32_t first) {
+        return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first)),
+                                                    _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    }
+    static V noIndex() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    // Integer counts plus one in the lanes set in mask (a set mask lane is -1)
+    static V countMask(V counts, V mask) {
+        return _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_castps_si256(counts), _mm256_castps_si256(mask)));
+    }
+    static void storeIntegers(uint32_t* p, V v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_castps_si256(v));
+    }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static V cmplt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static V cmple(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static V cmpgt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V cmpge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static V andMask(V a, V b) { return _mm256_and_ps(a, b); }
+    static bool anyMask(V mask) { return _mm256_movemask_ps(mask) != 0; }
+    // mask ? a : b
+    static V select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+    // Operand order makes NaN propagate like glm::clamp (degenerate edges)
+    static V clamp01(V a) { return _mm256_min_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(_mm256_setzero_ps(), a)); }
+    static V dot(V ax, V ay, V az, V bx, V by, V bz) {
+        return add(add(mul(ax, bx), mul(ay, by)), mul(az, bz));
+    }
+};
+
+} // namespace
+
+bool isAvx2TriangleKernelAvailable() { return true; }
+
+int64_t findDeepestCandidateAvx2(const float* data, uint32_t stride, uint32_t begin, uint32_t end,
+                                 float center_x, float center_y, float center_z,
+                                 float radius, float max_depth, uint32_t& hit_count) {
+    return findDeepestCandidate<Avx2Ops>(data, stride, begin, end, center_x, center_y, center_z,
+                                         radius, max_depth, hit_count);
+}
+
+#else
+
+// Built without AVX2 support (non-x86 target or compiler without -mavx2)
+bool isAvx2TriangleKernelAvailable() { return false; }
+
+int64_t findDeepestCandidateAvx2(const float*, uint32_t, uint32_t, uint32_t,
+                                 float, float, float, float, float, uint32_t&) {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef TRIANGLE_BATCH_KERNEL_H
+#define TRIANGLE_BATCH_KERNEL_H
+
+// Internal to TriangleBatch.cpp / TriangleBatchAvx2.cpp.
+// The kernel is written once against a small "Ops" wrapper and instantiated
+// per instruction set. It deliberately avoids glm: the AVX2 translation unit
+// is built with different compiler flags, and sharing inline glm code between
+// the two would let AVX2 instructions leak into the baseline build.
+
+#include <cstdint>
+
+namespace {
+
+// SoA rows, one per TriangleRecord field. Must match MathUtils::
+// TRIANGLE_SOA_COMPONENTS (checked in TriangleBatch.cpp).
+enum TriangleSoAComponent {
+    SOA_A_X, SOA_A_Y, SOA_A_Z,
+    SOA_AB_X, SOA_AB_Y, SOA_AB_Z,
+    SOA_AC_X, SOA_AC_Y, SOA_AC_Z,
+    SOA_N_X, SOA_N_Y, SOA_N_Z,
+    SOA_AB_AB, SOA_AB_AC, SOA_AC_AC,
+    SOA_INV_AB_AB, SOA_INV_AC_AC, SOA_INV_BC_BC,
+    SOA_MIN_X, SOA_MIN_Y, SOA_MIN_Z,
+    SOA_MAX_X, SOA_MAX_Y, SOA_MAX_Z,
+    SOA_COMPONENT_COUNT
+};
+
+// best_index of lanes that found nothing (all bits set, see Ops::noIndex)
+const uint32_t KERNEL_NO_INDEX = 0xFFFFFFFFu;
+
+// Branch-free version of checkSphereTriangleRecord. Every Voronoi region is
+// evaluated for every lane and the result picked with masks, in the same
+// priority order and with the same arithmetic as the scalar code, so both
+// agree bit for bit. Blocks whose bounds all miss the sphere are skipped.
+// Returns the index of the deepest contact in [begin, end) that is strictly
+// deeper than max_depth (lowest index on ties), or -1. Adds the number of
+// triangles touching the sphere to hit_count.
+// Triangle indices and hit counts ride in the vectors as 32-bit integers
+// (Ops::indices, Ops::countMask), since floats only hold them exactly below
+// 2^24; masks and selects work on the bits either way.
+template <typename Ops>
+int64_t findDeepestCandidate(const float* data, uint32_t stride, uint32_t begin, uint32_t end,
+                             float center_x, float center_y, float center_z,
+                             float radius, float max_depth, uint32_t& hit_count) {
+    typedef typename Ops::V V;
+    const int W = Ops::WIDTH;
+
+    const V px = Ops::set1(center_x);
+    const V py = Ops::set1(center_y);
+    const V pz = Ops::set1(center_z);
+    const V r = Ops::set1(radius);
+    const V r_sq = Ops::mul(r, r);
+    const V zero = Ops::set1(0.0f);
+    const V lane_offsets = Ops::laneOffsets();
+
+    V best_depth = Ops::set1(max_depth);
+    V best_index = Ops::noIndex();
+    V hits = zero; // Per-lane contact counts; the bits of 0.0f are integer 0 too
+
+    for (uint32_t base = begin; base < end; base += W) {
+        const float* p = data + base;
+        // Bounds first: most candidates from a node only come near the sphere
+        V in_bounds = Ops::andMask(
+            Ops::andMask(Ops::cmpge(px, Ops::sub(Ops::load(p + SOA_MIN_X * stride), r)),
+                         Ops::cmple(px, Ops::add(Ops::load(p + SOA_MAX_X * stride), r))),
+            Ops::andMask(Ops::andMask(Ops::cmpge(py, Ops::sub(Ops::load(p + SOA_MIN_Y * stride), r)),
+                                      Ops::cmple(py, Ops::add(Ops::load(p + SOA_MAX_Y * stride), r))),
+                         Ops::andMask(Ops::cmpge(pz, Ops::sub(Ops::load(p + SOA_MIN_Z * stride), r)),
+                                      Ops::cmple(pz, Ops::add(Ops::load(p + SOA_MAX_Z * stride), r)))));
+        if (!Ops::anyMask(in_bounds)) continue;
+
+        V ax = Ops::load(p + SOA_A_X * stride), ay = Ops::load(p + SOA_A_Y * stride), az = Ops::load(p + SOA_A_Z * stride);
+        V abx = Ops::load(p + SOA_AB_X * stride), aby = Ops::load(p + SOA_AB_Y * stride), abz = Ops::load(p + SOA_AB_Z * stride);
+        V acx = Ops::load(p + SOA_AC_X * stride), acy = Ops::load(p + SOA_AC_Y * stride), acz = Ops::load(p + SOA_AC_Z * stride);
+        V ab_ab = Ops::load(p + SOA_AB_AB * stride);
+        V ab_ac = Ops::load(p + SOA_AB_AC * stride);
+        V ac_ac = Ops::load(p + SOA_AC_AC * stride);
+
+        V apx = Ops::sub(px, ax), apy = Ops::sub(py, ay), apz = Ops::sub(pz, az);
+        V d1 = Ops::dot(abx, aby, abz, apx, apy, apz);
+        V d2 = Ops::dot(acx, acy, acz, apx, apy, apz);
+        V d3 = Ops::sub(d1, ab_ab);
+        V d4 = Ops::sub(d2, ab_ac);
+        V d5 = Ops::sub(d1, ab_ac);
+        V d6 = Ops::sub(d2, ac_ac);
+
+        V vc = Ops::sub(Ops::mul(d1, d4), Ops::mul(d3, d2));
+        V vb = Ops::sub(Ops::mul(d5, d2), Ops::mul(d1, d6));
+        V va = Ops::sub(Ops::mul(d3, d6), Ops::mul(d5, d4));
+
+        V in_a = Ops::andMask(Ops::cmple(d1, zero), Ops::cmple(d2, zero));
+        V in_b = Ops::andMask(Ops::cmpge(d3, zero), Ops::cmple(d4, d3));
+        V in_ab = Ops::andMask(Ops::cmple(vc, zero), Ops::andMask(Ops::cmpge(d1, zero), Ops::cmple(d3, zero)));
+        V in_c = Ops::andMask(Ops::cmpge(d6, zero), Ops::cmple(d5, d6));
+        V in_ac = Ops::andMask(Ops::cmple(vb, zero), Ops::andMask(Ops::cmpge(d2, zero), Ops::cmple(d6, zero)));
+        V in_bc = Ops::andMask(Ops::cmple(va, zero),
+                               Ops::andMask(Ops::cmpge(Ops::sub(d4, d3), zero), Ops::cmpge(Ops::sub(d5, d6), zero)));
+
+        V bx = Ops::add(ax, abx), by = Ops::add(ay, aby), bz = Ops::add(az, abz);
+        V cx = Ops::add(ax, acx), cy = Ops::add(ay, acy), cz = Ops::add(az, acz);
+
+        // Face region: project onto the plane
+        V nx = Ops::load(p + SOA_N_X * stride), ny = Ops::load(p + SOA_N_Y * stride), nz = Ops::load(p + SOA_N_Z * stride);
+        V dist = Ops::dot(apx, apy, apz, nx, ny, nz);
+        V qx = Ops::sub(px, Ops::mul(dist, nx));
+        V qy = Ops::sub(py, Ops::mul(dist, ny));
+        V qz = Ops::sub(pz, Ops::mul(dist, nz));
+
+        // Edge BC
+        V bcx = Ops::sub(acx, abx), bcy = Ops::sub(acy, aby), bcz = Ops::sub(acz, abz);
+        V t = Ops::clamp01(Ops::mul(Ops::sub(d4, d3), Ops::load(p + SOA_INV_BC_BC * stride)));
+        qx = Ops::select(in_bc, Ops::add(bx, Ops::mul(t, bcx)), qx);
+        qy = Ops::select(in_bc, Ops::add(by, Ops::mul(t, bcy)), qy);
+        qz = Ops::select(in_bc, Ops::add(bz, Ops::mul(t, bcz)), qz);
+
+        // Edge AC
+        t = Ops::clamp01(Ops::mul(d2, Ops::load(p + SOA_INV_AC_AC * stride)));
+        qx = Ops::select(in_ac, Ops::add(ax, Ops::mul(t, acx)), qx);
+        qy = Ops::select(in_ac, Ops::add(ay, Ops::mul(t, acy)), qy);
+        qz = Ops::select(in_ac, Ops::add(az, Ops::mul(t, acz)), qz);
+
+        // Vertex C
+        qx = Ops::select(in_c, cx, qx);
+        qy = Ops::select(in_c, cy, qy);
+        qz = Ops::select(in_c, cz, qz);
+
+        // Edge AB
+        t = Ops::clamp01(Ops::mul(d1, Ops::load(p + SOA_INV_AB_AB * stride)));
+        qx = Ops::select(in_ab, Ops::add(ax, Ops::mul(t, abx)), qx);
+        qy = Ops::select(in_ab, Ops::add(ay, Ops::mul(t, aby)), qy);
+        qz = Ops::select(in_ab, Ops::add(az, Ops::mul(t, abz)), qz);
+
+        // Vertex B, then vertex A (highest priority)
+        qx = Ops::select(in_b, bx, qx);
+        qy = Ops::select(in_b, by, qy);
+        qz = Ops::select(in_b, bz, qz);
+        qx = Ops::select(in_a, ax, qx);
+        qy = Ops::select(in_a, ay, qy);
+        qz = Ops::select(in_a, az, qz);
+
+        V dx = Ops::sub(px, qx), dy = Ops::sub(py, qy), dz = Ops::sub(pz, qz);
+        V dist_sq = Ops::dot(dx, dy, dz, dx, dy, dz);
+        V depth = Ops::sub(r, Ops::sqrt(dist_sq));
+
+        // Lanes past `end` are padding; lane numbers are small enough to compare as floats
+        uint32_t remaining = end - base;
+        V valid = Ops::cmplt(lane_offsets, Ops::set1(static_cast<float>(remaining < W ? remaining : W)));
+        V index = Ops::indices(base);
+        V contact = Ops::andMask(Ops::andMask(valid, in_bounds), Ops::cmplt(dist_sq, r_sq));
+        V better = Ops::andMask(contact, Ops::cmpgt(depth, best_depth));
+        hits = Ops::countMask(hits, contact);
+        best_depth = Ops::select(better, depth, best_depth);
+        best_index = Ops::select(better, index, best_index);
+    }
+
+    // Horizontal reduction: deepest lane, lowest triangle index on ties
+    float depths[8];
+    uint32_t indices[8];
+    uint32_t lane_hits[8];
+    Ops::store(depths, best_depth);
+    Ops::storeIntegers(indices, best_index);
+    Ops::storeIntegers(lane_hits, hits);
+    for (int i = 0; i < W; ++i) {
+        hit_count += lane_hits[i];
+    }
+    int64_t result = -1;
+    float result_depth = max_depth;
+    for (int i = 0; i < W; ++i) {
+        if (indices[i] == KERNEL_NO_INDEX) continue;
+        if (depths[i] > result_depth || (depths[i] == result_depth && result >= 0 && indices[i] < result)) {
+            result_depth = depths[i];
+            result = indices[i];
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+#endif
@@ -2,87 +2,68 @@
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <cmath>
 #include <iostream>
 
-// Helpers for Assimp -> GLM conversion
-static glm::mat4 castMatrix(const aiMatrix4x4 &from) {
-    glm::mat4 to;
-    to[0][0] = from.a1;
-    to[1][0] = from.a2;
-    to[2][0] = from.a3;
-    to[3][0] = from.a4;
-    to[0][1] = from.b1;
-    to[1][1] = from.b2;
-    to[2][1] = from.b3;
-    to[3][1] = from.b4;
-    to[0][2] = from.c1;
-    to[1][2] = from.c2;
-    to[2][2] = from.c3;
-    to[3][2] = from.c4;
-    to[0][3] = from.d1;
-    to[1][3] = from.d2;
-    to[2][3] = from.d3;
-    to[3][3] = from.d4;
-    return to;
-}
-
 // --- BoneAnimation Implementation ---
 
-int BoneAnimation::getPositionIndex(float animation_time) {
-    for (int i = 0; i < positions.size() - 1; ++i) {
-        if (animation_time < positions[i + 1].time_stamp)
-            return i;
-    }
-    return 0;
+// Index of the key starting the segment around animation_time, clamped to
+// the first and last segments. Searches on from cursor, which playback only
+// ever moves forwards between loops, and leaves it at the answer.
+template <typename Key>
+int findKeyIndex(const std::vector<Key> &keys, float animation_time,
+                 int &cursor) {
+    int last_segment = static_cast<int>(keys.size()) - 2;
+    if (cursor > last_segment || animation_time < keys[cursor].time_stamp)
+        cursor = 0; // Looped, or a different track
+    while (cursor < last_segment &&
+           animation_time >= keys[cursor + 1].time_stamp)
+        ++cursor;
+    return cursor;
 }
 
-int BoneAnimation::getRotationIndex(float animation_time) {
-    for (int i = 0; i < rotations.size() - 1; ++i) {
-        if (animation_time < rotations[i + 1].time_stamp)
-            return i;
-    }
-    return 0;
+int BoneAnimation::getPositionIndex(float animation_time, int &cursor) {
+    return findKeyIndex(positions, animation_time, cursor);
 }
 
-int BoneAnimation::getScaleIndex(float animation_time) {
-    for (int i = 0; i < scales.size() - 1; ++i) {
-        if (animation_time < scales[i + 1].time_stamp)
-            return i;
-    }
-    return 0;
+int BoneAnimation::getRotationIndex(float animation_time, int &cursor) {
+    return findKeyIndex(rotations, animation_time, cursor);
 }
 
+int BoneAnimation::getScaleIndex(float animation_time, int &cursor) {
+    return findKeyIndex(scales, animation_time, cursor);
+}
+
+// Clamped so times outside the keys hold the end values
 float getScaleFactor(float last_time_stamp, float next_time_stamp,
                      float animation_time) {
     float scale_factor = 0.0f;
     float mid_way_length = animation_time - last_time_stamp;
     float frames_diff = next_time_stamp - last_time_stamp;
     scale_factor = mid_way_length / frames_diff;
-    return scale_factor;
+    return glm::clamp(scale_factor, 0.0f, 1.0f);
 }
 
-glm::mat4 interpolatePosition(BoneAnimation &bone, float animation_time) {
+glm::vec3 samplePosition(BoneAnimation &bone, float animation_time,
+                         int &cursor) {
     if (bone.positions.size() == 1)
-        return glm::translate(glm::mat4(1.0f), bone.positions[0].position);
+        return bone.positions[0].position;
 
-    int p0_index = bone.getPositionIndex(animation_time);
+    int p0_index = bone.getPositionIndex(animation_time, cursor);
     int p1_index = p0_index + 1;
     float scale_factor =
         getScaleFactor(bone.positions[p0_index].time_stamp,
                        bone.positions[p1_index].time_stamp, animation_time);
-    glm::vec3 final_position =
-        glm::mix(bone.positions[p0_index].position,
-                 bone.positions[p1_index].position, scale_factor);
-    return glm::translate(glm::mat4(1.0f), final_position);
+    return glm::mix(bone.positions[p0_index].position,
+                    bone.positions[p1_index].position, scale_factor);
 }
 
-glm::mat4 interpolateRotation(BoneAnimation &bone, float animation_time) {
-    if (bone.rotations.size() == 1) {
-        auto rotation = glm::normalize(bone.rotations[0].orientation);
-        return glm::mat4_cast(rotation);
-    }
+glm::quat sampleRotation(BoneAnimation &bone, float animation_time,
+                         int &cursor) {
+    if (bone.rotations.size() == 1)
+        return glm::normalize(bone.rotations[0].orientation);
 
-    int p0_index = bone.getRotationIndex(animation_time);
+    int p0_index = bone.getRotationIndex(animation_time, cursor);
     int p1_index = p0_index + 1;
     float scale_factor =
         getScaleFactor(bone.rotations[p0_index].time_stamp,
@@ -90,58 +71,108 @@ glm::mat4 interpolateRotation(BoneAnimation &bone, float animation_time) {
     glm::quat final_rotation =
         glm::slerp(bone.rotations[p0_index].orientation,
                    bone.rotations[p1_index].orientation, scale_factor);
-    final_rotation = glm::normalize(final_rotation);
-    return glm::mat4_cast(final_rotation);
+    return glm::normalize(final_rotation);
 }
 
-glm::mat4 interpolateScaling(BoneAnimation &bone, float animation_time) {
+glm::vec3 sampleScale(BoneAnimation &bone, float animation_time, int &cursor) {
     if (bone.scales.size() == 1)
-        return glm::scale(glm::mat4(1.0f), bone.scales[0].scale);
+        return bone.scales[0].scale;
 
-    int p0_index = bone.getScaleIndex(animation_time);
+    int p0_index = bone.getScaleIndex(animation_time, cursor);
     int p1_index = p0_index + 1;
     float scale_factor =
         getScaleFactor(bone.scales[p0_index].time_stamp,
                        bone.scales[p1_index].time_stamp, animation_time);
-    glm::vec3 final_scale = glm::mix(bone.scales[p0_index].scale,
-                                     bone.scales[p1_index].scale, scale_factor);
-    return glm::scale(glm::mat4(1.0f), final_scale);
+    return glm::mix(bone.scales[p0_index].scale, bone.scales[p1_index].scale,
+                    scale_factor);
 }
 
-// --- Loading Logic ---
-
-void readHeirarchyData(AssimpNodeData &dest, const aiNode *src) {
-    dest.name = src->mName.data;
-    dest.transformation = castMatrix(src->mTransformation);
-    dest.children_count = src->mNumChildren;
+// translate(position) * mat4_cast(rotation) * scale(scale), built directly
+glm::mat4 composeTransform(const glm::vec3 &position, const glm::quat &rotation,
+                           const glm::vec3 &scale) {
+    glm::mat4 transform = glm::mat4_cast(rotation);
+    transform[0] *= scale.x;
+    transform[1] *= scale.y;
+    transform[2] *= scale.z;
+    transform[3] = glm::vec4(position, 1.0f);
+    return transform;
+}
 
-    for (int i = 0; i < src->mNumChildren; i++) {
-        AssimpNodeData new_data;
-        readHeirarchyData(new_data, src->mChildren[i]);
-        dest.children.push_back(new_data);
+// Samples every channel at 0, frame_interval, 2 * frame_interval, ... up to
+// the first frame at or past the end of the clip, into SoA streams
+PoseStreams resampleAnimation(Animation &animation, float frame_interval) {
+    uint32_t frame_count =
+        static_cast<uint32_t>(std::ceil(animation.duration / frame_interval)) +
+        1;
+    PoseStreams streams = createPoseStreams(
+        static_cast<uint32_t>(animation.bones.size()), frame_count,
+        frame_interval);
+    std::vector<glm::vec3> positions(frame_count);
+    std::vector<glm::quat> rotations(frame_count);
+    std::vector<glm::vec3> scales(frame_count);
+    for (uint32_t channel = 0; channel < animation.bones.size(); channel++) {
+        BoneAnimation &bone = animation.bones[channel];
+        KeyCursor cursor;
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            float time = frame * frame_interval;
+            positions[frame] = samplePosition(bone, time, cursor.position);
+            rotations[frame] = sampleRotation(bone, time, cursor.rotation);
+            scales[frame] = sampleScale(bone, time, cursor.scale);
+        }
+        setPoseStreamChannel(streams, channel, positions, rotations, scales);
     }
+    return streams;
 }
 
-Animation loadAnimation(const std::string &animation_path, Model *model) {
-    Animation animation;
-    animation.bone_info_map = model->bone_info_map; // Copy bone info from model
+// Moves every channel's keys into a CompressedClip
+CompressedClip compressAnimation(Animation &animation, float tolerance) {
+    CompressedClip clip = createCompressedClip(animation.duration);
+    for (auto &bone : animation.bones) {
+        std::vector<float> times;
+        std::vector<glm::vec3> vectors;
+        std::vector<glm::quat> rotations;
+        CompressedChannel channel;
+
+        for (const auto &key : bone.positions) {
+            times.push_back(key.time_stamp);
+            vectors.push_back(key.position);
+        }
+        channel.position =
+            addCompressedVectorTrack(clip, times, vectors, tolerance);
 
-    Assimp::Importer importer;
-    const aiScene *scene =
-        importer.ReadFile(animation_path, aiProcess_Triangulate);
+        times.clear();
+        for (const auto &key : bone.rotations) {
+            times.push_back(key.time_stamp);
+            rotations.push_back(key.orientation);
+        }
+        channel.rotation =
+            addCompressedRotationTrack(clip, times, rotations, tolerance);
+
+        times.clear();
+        vectors.clear();
+        for (const auto &key : bone.scales) {
+            times.push_back(key.time_stamp);
+            vectors.push_back(key.scale);
+        }
+        channel.scale =
+            addCompressedVectorTrack(clip, times, vectors, tolerance);
 
-    // Check if scene has animations
-    if (!scene || !scene->mRootNode || scene->mNumAnimations == 0) {
-        std::cout << "Animation Load Error: No animations found in "
-                  << animation_path << std::endl;
-        return animation;
+        clip.channels.push_back(channel);
     }
+    return clip;
+}
+
+// --- Loading Logic ---
 
-    auto anim = scene->mAnimations[0]; // Load the first animation
+// Reads one clip's channels and binds them to the skeleton's joints
+Animation readAnimation(const aiAnimation *anim,
+                        const std::shared_ptr<const Skeleton> &skeleton,
+                        const AnimationLoadSettings &settings) {
+    Animation animation;
+    animation.name = anim->mName.data;
     animation.duration = anim->mDuration;
     animation.ticks_per_second = anim->mTicksPerSecond;
-
-    readHeirarchyData(animation.root_node, scene->mRootNode);
+    animation.skeleton = skeleton;
 
     // Read channels (Bone Animations)
     for (int i = 0; i < anim->mNumChannels; i++) {
@@ -149,13 +180,6 @@ Animation loadAnimation(const std::string &animation_path, Model *model) {
         BoneAnimation bone;
         bone.name = channel->mNodeName.data;
 
-        if (animation.bone_info_map.find(bone.name) ==
-            animation.bone_info_map.end()) {
-            bone.id = -1;
-        } else {
-            bone.id = animation.bone_info_map[bone.name].id;
-        }
-
         // Key positions
         for (int j = 0; j < channel->mNumPositionKeys; j++) {
             aiVector3D ai_pos = channel->mPositionKeys[j].mValue;
@@ -184,9 +208,89 @@ Animation loadAnimation(const std::string &animation_path, Model *model) {
         animation.bones.push_back(bone);
     }
 
+    // Streams store every frame of every channel, moving or not, so they only
+    // replace the keys when they come out no bigger than what would be kept
+    // otherwise: the compressed keys, or the imported ones
+    size_t key_bytes = getAnimationBytes(animation);
+    bool compress = settings.compression_tolerance > 0.0f;
+    if (compress) {
+        animation.compressed =
+            compressAnimation(animation, settings.compression_tolerance);
+        key_bytes = getCompressedClipBytes(animation.compressed);
+    }
+    if (settings.resample_rate > 0.0f && animation.ticks_per_second > 0) {
+        animation.streams = resampleAnimation(
+            animation, animation.ticks_per_second / settings.resample_rate);
+        if (getPoseStreamsBytes(animation.streams) <= key_bytes) {
+            animation.compressed = CompressedClip();
+        } else {
+            animation.streams = PoseStreams();
+        }
+    }
+    if (compress || animation.streams.frame_count > 0) {
+        // The streams or the compressed clip hold what the keys did
+        for (auto &bone : animation.bones) {
+            bone.positions = std::vector<KeyPosition>();
+            bone.rotations = std::vector<KeyRotation>();
+            bone.scales = std::vector<KeyScale>();
+        }
+    }
+
+    // Resolve names once here so updates never compare strings. Channels
+    // for nodes the skeleton doesn't have are never sampled.
+    animation.joint_channels.assign(skeleton->joints.size(), -1);
+    for (int i = 0; i < animation.bones.size(); i++) {
+        int joint = findSkeletonJoint(*skeleton, animation.bones[i].name);
+        if (joint != -1 && animation.joint_channels[joint] == -1)
+            animation.joint_channels[joint] = i; // First one wins
+    }
+
     return animation;
 }
 
+AnimationLibrary loadAnimationLibrary(const std::string &animation_path,
+                                      const Model &model,
+                                      const AnimationLoadSettings &settings) {
+    AnimationLibrary library;
+    library.skeleton = model.skeleton;
+    if (!library.skeleton) {
+        std::cout << "Animation Load Error: " << model.source_path
+                  << " has no skeleton" << std::endl;
+        return library;
+    }
+
+    Assimp::Importer importer;
+    const aiScene *scene =
+        importer.ReadFile(animation_path, aiProcess_Triangulate);
+
+    // Check if scene has animations
+    if (!scene || !scene->mRootNode || scene->mNumAnimations == 0) {
+        std::cout << "Animation Load Error: No animations found in "
+                  << animation_path << std::endl;
+        return library;
+    }
+
+    for (int i = 0; i < scene->mNumAnimations; i++) {
+        library.clips.push_back(
+            readAnimation(scene->mAnimations[i], library.skeleton, settings));
+        Animation &clip = library.clips.back();
+        if (clip.name.empty())
+            clip.name = std::to_string(i);
+        if (!library.clip_indices.emplace(clip.name, i).second) {
+            std::cout << "Animation Load Warning: " << animation_path
+                      << " has more than one clip named " << clip.name
+                      << std::endl;
+        }
+    }
+    return library;
+}
+
+Animation *findAnimation(AnimationLibrary &library, const std::string &name) {
+    auto clip = library.clip_indices.find(name);
+    return clip == library.clip_indices.end() ? nullptr
+                                              : &library.clips[clip->second];
+}
+
 // --- Animator Logic ---
 
 void playAnimation(Animator &animator, Animation *animation) {
@@ -194,49 +298,80 @@ void playAnimation(Animator &animator, Animation *animation) {
     animator.current_time = 0.0f;
     animator.final_bone_matrices.clear();
     animator.final_bone_matrices.resize(100, glm::mat4(1.0f)); // Max 100 bones
+    animator.cursors.assign(animation ? animation->bones.size() : 0,
+                            KeyCursor());
 }
 
-BoneAnimation *findBoneAnimation(Animation *animation,
-                                 const std::string &node_name) {
-    for (auto &bone : animation->bones) {
-        if (bone.name == node_name) {
-            return &bone;
-        }
-    }
-    return nullptr;
-}
-
-void calculateBoneTransform(Animator &animator, const AssimpNodeData *node,
-                            glm::mat4 parent_transform) {
-    std::string node_name = node->name;
-    glm::mat4 node_transform = node->transformation;
-
-    BoneAnimation *bone =
-        findBoneAnimation(animator.current_animation, node_name);
-
-    if (bone) {
-        glm::mat4 trans = interpolatePosition(*bone, animator.current_time);
-        glm::mat4 rot = interpolateRotation(*bone, animator.current_time);
-        glm::mat4 scale = interpolateScaling(*bone, animator.current_time);
-        node_transform = trans * rot * scale;
+void calculateBoneTransforms(Animator &animator) {
+    Animation &animation = *animator.current_animation;
+    const Skeleton &skeleton = *animation.skeleton;
+    animator.global_transforms.resize(skeleton.joints.size());
+
+    // Resampled clips sample every channel in one SIMD pass up front
+    const PoseStreams &streams = animation.streams;
+    bool resampled = streams.frame_count > 0;
+    const CompressedClip &compressed = animation.compressed;
+    bool is_compressed = !compressed.channels.empty();
+    if (resampled) {
+        animator.local_affines.resize(POSE_AFFINE_COMPONENTS * streams.stride);
+        samplePoseStreams(streams, animator.current_time,
+                          animator.local_affines.data());
     }
 
-    glm::mat4 global_transformation = parent_transform * node_transform;
-
-    auto &bone_info_map = animator.current_animation->bone_info_map;
-    if (bone_info_map.find(node_name) != bone_info_map.end()) {
-        int index = bone_info_map[node_name].id;
-        glm::mat4 offset = bone_info_map[node_name].offset;
+    for (int i = 0; i < skeleton.joints.size(); i++) {
+        const SkeletonJoint &joint = skeleton.joints[i];
+        int channel_index = animation.joint_channels[i];
+        glm::mat4 node_transform = joint.transformation;
+
+        if (channel_index != -1 && resampled) {
+            node_transform = getPoseAffine(animator.local_affines.data(),
+                                           streams.stride, channel_index);
+        } else if (channel_index != -1 && is_compressed) {
+            const CompressedChannel &channel =
+                compressed.channels[channel_index];
+            KeyCursor &cursor = animator.cursors[channel_index];
+            float time = animator.current_time;
+            node_transform = composeTransform(
+                sampleCompressedVector(compressed, channel.position, time,
+                                       cursor.position),
+                sampleCompressedRotation(compressed, channel.rotation, time,
+                                         cursor.rotation),
+                sampleCompressedVector(compressed, channel.scale, time,
+                                       cursor.scale));
+        } else if (channel_index != -1) {
+            BoneAnimation &bone = animation.bones[channel_index];
+            KeyCursor &cursor = animator.cursors[channel_index];
+            float time = animator.current_time;
+            node_transform =
+                composeTransform(samplePosition(bone, time, cursor.position),
+                                 sampleRotation(bone, time, cursor.rotation),
+                                 sampleScale(bone, time, cursor.scale));
+        }
 
-        if (index < animator.final_bone_matrices.size())
-            animator.final_bone_matrices[index] =
-                global_transformation * offset;
+        // The parent's entry is already this update's, as it comes first
+        glm::mat4 global_transformation =
+            joint.parent == -1
+                ? node_transform
+                : animator.global_transforms[joint.parent] * node_transform;
+        animator.global_transforms[i] = global_transformation;
+
+        if (joint.bone != -1 &&
+            joint.bone < animator.final_bone_matrices.size())
+            animator.final_bone_matrices[joint.bone] =
+                global_transformation * joint.offset;
     }
+}
 
-    for (int i = 0; i < node->children_count; i++) {
-        calculateBoneTransform(animator, &node->children[i],
-                               global_transformation);
+size_t getAnimationBytes(const Animation &animation) {
+    size_t bytes = getPoseStreamsBytes(animation.streams) +
+                   getCompressedClipBytes(animation.compressed) +
+                   animation.joint_channels.size() * sizeof(int);
+    for (const auto &bone : animation.bones) {
+        bytes += bone.positions.size() * sizeof(KeyPosition) +
+                 bone.rotations.size() * sizeof(KeyRotation) +
+                 bone.scales.size() * sizeof(KeyScale);
     }
+    return bytes;
 }
 
 void updateAnimator(Animator &animator, float dt) {
@@ -250,6 +385,5 @@ void updateAnimator(Animator &animator, float dt) {
     animator.current_time =
         fmod(animator.current_time, animator.current_animation->duration);
 
-    calculateBoneTransform(animator, &animator.current_animation->root_node,
-                           glm::mat4(1.0f));
+    calculateBoneTransforms(animator);
 }
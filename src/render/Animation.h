@@ -1,10 +1,13 @@
 #ifndef ANIMATION_H
 #define ANIMATION_H
 
-#include "Model.h" // For BoneInfo
+#include "CompressedClip.h"
+#include "Model.h"
+#include "PoseStreams.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,45 +29,86 @@ struct KeyScale {
 // Represents the animation curves for a single bone
 struct BoneAnimation {
     std::string name;
-    int id;
     std::vector<KeyPosition> positions;
     std::vector<KeyRotation> rotations;
     std::vector<KeyScale> scales;
 
-    // Helpers to find the index of the keyframe just before the current time
-    int getPositionIndex(float animation_time);
-    int getRotationIndex(float animation_time);
-    int getScaleIndex(float animation_time);
+    // Helpers to find the index of the keyframe just before the current time.
+    // cursor is the caller's last answer for the track (see KeyCursor); the
+    // search starts there.
+    int getPositionIndex(float animation_time, int &cursor);
+    int getRotationIndex(float animation_time, int &cursor);
+    int getScaleIndex(float animation_time, int &cursor);
 };
 
-// Represents the hierarchy of bones (mirroring Assimp's node structure)
-struct AssimpNodeData {
-    glm::mat4 transformation;
-    std::string name;
-    int children_count;
-    std::vector<AssimpNodeData> children;
+// Last key index found in each track of one channel. Playback only moves
+// forwards, so the next search usually ends within a key or two of it.
+struct KeyCursor {
+    int position = 0;
+    int rotation = 0;
+    int scale = 0;
 };
 
-// Holds the entire animation clip
+// Holds the entire animation clip. Only the curves are the clip's own; the
+// hierarchy and bones come from the model's shared skeleton.
 struct Animation {
+    std::string name;
     float duration;
     int ticks_per_second;
+    std::shared_ptr<const Skeleton> skeleton;
     std::vector<BoneAnimation> bones; // Vector of all bones involved
-    AssimpNodeData root_node;
-    std::map<std::string, BoneInfo> bone_info_map; // Copy of model's bone info
+    // Per skeleton joint: index in bones, -1 if the clip doesn't animate it
+    std::vector<int> joint_channels;
+    // Set when the clip was resampled at load, which also empties the bones'
+    // keys: every channel on one uniform grid, sampled all at once
+    PoseStreams streams;
+    // Set instead when the clip was compressed at load; channel i holds what
+    // bones[i]'s keys did
+    CompressedClip compressed;
 };
 
 // Holds the runtime state of the animation
 struct Animator {
     std::vector<glm::mat4> final_bone_matrices;
+    std::vector<glm::mat4> global_transforms; // Per joint, reused every update
+    std::vector<KeyCursor> cursors;   // Per channel of current_animation
+    std::vector<float> local_affines; // samplePoseStreams output, if resampled
     Animation *current_animation;
     float current_time;
     float delta_time;
 };
 
+// Every clip of an animation file, bound to one model's skeleton
+struct AnimationLibrary {
+    std::shared_ptr<const Skeleton> skeleton;
+    // Filled once at load and never resized after, so Animator pointers into
+    // it stay valid
+    std::vector<Animation> clips;
+    std::map<std::string, int> clip_indices; // Clip name to index in clips
+};
+
 // --- Functions ---
 
-Animation loadAnimation(const std::string &animation_path, Model *model);
+struct AnimationLoadSettings {
+    // If > 0, frames per second to resample the clip to (see
+    // Animation::streams), if the streams take no more memory than the keys
+    // (compressed, if compression_tolerance is set) they replace
+    float resample_rate = 0.0f;
+    // If > 0 and the clip isn't resampled, compress its keys (see
+    // CompressedClip.h), dropping those interpolation reproduces within this
+    // many units of translation or scale, or radians of rotation
+    float compression_tolerance = 0.0f;
+};
+
+// Loads every clip in the file for the model, which must have a skeleton
+AnimationLibrary loadAnimationLibrary(const std::string &animation_path,
+                                      const Model &model,
+                                      const AnimationLoadSettings &settings =
+                                          AnimationLoadSettings());
+// nullptr if the library has no clip of that name
+Animation *findAnimation(AnimationLibrary &library, const std::string &name);
+// Memory held by the clip's curves, in whichever form they are kept
+size_t getAnimationBytes(const Animation &animation);
 void updateAnimator(Animator &animator, float dt);
 void playAnimation(Animator &animator, Animation *animation);
 
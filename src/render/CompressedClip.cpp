@@ -0,0 +1,252 @@
+#include "CompressedClip.h"
+#include <algorithm>
+#include <cmath>
+
+const float QUANTIZED_TIME_MAX = 65535.0f;
+const float QUANTIZED_VECTOR_MAX = 65535.0f;
+
+// --- Packing ---
+
+PackedQuat packQuat(glm::quat rotation) {
+    rotation = glm::normalize(rotation);
+    float c[4] = {rotation.x, rotation.y, rotation.z, rotation.w};
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (std::fabs(c[i]) > std::fabs(c[largest]))
+            largest = i;
+    }
+    // q and -q are the same rotation; keep the dropped component positive
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+    PackedQuat packed;
+    int slot = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest)
+            continue;
+        float unit = glm::clamp(c[i] * sign / PACKED_QUAT_RANGE, -1.0f, 1.0f);
+        float q = (unit * 0.5f + 0.5f) * PACKED_QUAT_COMPONENT_MAX;
+        packed.v[slot++] = static_cast<uint16_t>(std::floor(q + 0.5f));
+    }
+    packed.v[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+    packed.v[1] |= static_cast<uint16_t>((largest & 1) << 15);
+    return packed;
+}
+
+glm::quat unpackQuat(const PackedQuat &packed) {
+    int largest = (packed.v[0] >> 15) << 1 | packed.v[1] >> 15;
+    float c[4];
+    float sum = 0.0f;
+    int slot = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i == largest)
+            continue;
+        float unit = (packed.v[slot++] & 0x7fff) / PACKED_QUAT_COMPONENT_MAX;
+        c[i] = (unit * 2.0f - 1.0f) * PACKED_QUAT_RANGE;
+        sum += c[i] * c[i];
+    }
+    c[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+// --- Interpolation ---
+// The sampler and the key reduction must agree on these
+
+glm::vec3 interpolateKeys(const glm::vec3 &a, const glm::vec3 &b, float t) {
+    return glm::mix(a, b, t);
+}
+
+// nlerp along the shorter arc
+glm::quat interpolateKeys(const glm::quat &a, const glm::quat &b, float t) {
+    glm::quat to = glm::dot(a, b) < 0.0f ? -b : b;
+    return glm::normalize(a * (1.0f - t) + to * t);
+}
+
+float getKeyError(const glm::vec3 &a, const glm::vec3 &b) {
+    glm::vec3 d = glm::abs(a - b);
+    return std::max(d.x, std::max(d.y, d.z));
+}
+
+// Angle between the two rotations, from the chord between the quaternions
+// (acos of their dot product loses small angles to rounding)
+float getKeyError(const glm::quat &a, const glm::quat &b) {
+    glm::quat from = glm::normalize(a);
+    glm::quat to = glm::normalize(b);
+    if (glm::dot(from, to) < 0.0f)
+        to = -to;
+    glm::quat d = from - to;
+    float chord = std::sqrt(glm::dot(d, d));
+    return 4.0f * std::asin(std::min(chord * 0.5f, 1.0f));
+}
+
+// --- Key Reduction ---
+
+// Indices of the keys to keep: greedily extends each segment from the last
+// kept key while interpolating across it reproduces every key it skips
+template <typename Value>
+std::vector<uint32_t> reduceKeys(const std::vector<float> &times,
+                                 const std::vector<Value> &values,
+                                 float tolerance) {
+    std::vector<uint32_t> kept;
+    uint32_t count = static_cast<uint32_t>(values.size());
+    if (count == 0)
+        return kept;
+
+    kept.push_back(0);
+    bool constant = true;
+    for (uint32_t i = 1; i < count && constant; ++i) {
+        constant = getKeyError(values[0], values[i]) <= tolerance;
+    }
+    if (constant)
+        return kept;
+
+    uint32_t anchor = 0;
+    for (uint32_t end = 2; end < count; ++end) {
+        float span = times[end] - times[anchor];
+        for (uint32_t k = anchor + 1; k < end; ++k) {
+            float t = span > 0.0f ? (times[k] - times[anchor]) / span : 0.0f;
+            Value interpolated =
+                interpolateKeys(values[anchor], values[end], t);
+            if (getKeyError(interpolated, values[k]) > tolerance) {
+                anchor = end - 1;
+                kept.push_back(anchor);
+                break;
+            }
+        }
+    }
+    kept.push_back(count - 1);
+    return kept;
+}
+
+CompressedClip createCompressedClip(float duration) {
+    CompressedClip clip;
+    clip.time_step = duration > 0.0f ? duration / QUANTIZED_TIME_MAX : 1.0f;
+    return clip;
+}
+
+// Appends the times of the kept keys to out; returns the track with its key
+// run set
+CompressedTrack addCompressedTimes(const CompressedClip &clip,
+                                   std::vector<uint16_t> &out,
+                                   const std::vector<float> &times,
+                                   const std::vector<uint32_t> &kept) {
+    CompressedTrack track;
+    track.first_key = static_cast<uint32_t>(out.size());
+    track.key_count = static_cast<uint32_t>(kept.size());
+    for (uint32_t k : kept) {
+        float t = std::floor(times[k] / clip.time_step + 0.5f);
+        out.push_back(
+            static_cast<uint16_t>(glm::clamp(t, 0.0f, QUANTIZED_TIME_MAX)));
+    }
+    return track;
+}
+
+CompressedTrack addCompressedVectorTrack(CompressedClip &clip,
+                                         const std::vector<float> &times,
+                                         const std::vector<glm::vec3> &values,
+                                         float tolerance) {
+    std::vector<uint32_t> kept = reduceKeys(times, values, tolerance);
+    CompressedTrack track =
+        addCompressedTimes(clip, clip.vector_times, times, kept);
+    if (kept.empty())
+        return track;
+
+    glm::vec3 low = values[kept[0]];
+    glm::vec3 high = low;
+    for (uint32_t k : kept) {
+        low = glm::min(low, values[k]);
+        high = glm::max(high, values[k]);
+    }
+    track.origin = low;
+    track.step = (high - low) / QUANTIZED_VECTOR_MAX;
+    glm::vec3 inv_step(track.step.x > 0.0f ? 1.0f / track.step.x : 0.0f,
+                       track.step.y > 0.0f ? 1.0f / track.step.y : 0.0f,
+                       track.step.z > 0.0f ? 1.0f / track.step.z : 0.0f);
+    for (uint32_t k : kept) {
+        glm::vec3 q = glm::floor((values[k] - low) * inv_step + 0.5f);
+        q = glm::clamp(q, glm::vec3(0.0f), glm::vec3(QUANTIZED_VECTOR_MAX));
+        clip.vectors.push_back({static_cast<uint16_t>(q.x),
+                                static_cast<uint16_t>(q.y),
+                                static_cast<uint16_t>(q.z)});
+    }
+    return track;
+}
+
+CompressedTrack addCompressedRotationTrack(CompressedClip &clip,
+                                           const std::vector<float> &times,
+                                           const std::vector<glm::quat> &values,
+                                           float tolerance) {
+    std::vector<uint32_t> kept = reduceKeys(times, values, tolerance);
+    CompressedTrack track =
+        addCompressedTimes(clip, clip.rotation_times, times, kept);
+    for (uint32_t k : kept) {
+        clip.rotations.push_back(packQuat(values[k]));
+    }
+    return track;
+}
+
+// --- Sampling ---
+
+// Key starting the segment around animation_time and how far into it the
+// time is, searching on from cursor like findKeyIndex. times is the track's
+// run of its clip's vector_times or rotation_times.
+int findCompressedKey(const uint16_t *times, uint32_t key_count,
+                      float time_step, float animation_time, int &cursor,
+                      float &factor) {
+    int last_segment = static_cast<int>(key_count) - 2;
+    if (cursor > last_segment || animation_time < times[cursor] * time_step)
+        cursor = 0;
+    while (cursor < last_segment &&
+           animation_time >= times[cursor + 1] * time_step)
+        ++cursor;
+
+    float from = times[cursor] * time_step;
+    float to = times[cursor + 1] * time_step;
+    factor = to > from ? glm::clamp((animation_time - from) / (to - from),
+                                    0.0f, 1.0f)
+                       : 0.0f;
+    return cursor;
+}
+
+glm::vec3 decodeCompressedVector(const CompressedTrack &track,
+                                 const PackedVec3 &packed) {
+    return track.origin + glm::vec3(packed.x, packed.y, packed.z) * track.step;
+}
+
+glm::vec3 sampleCompressedVector(const CompressedClip &clip,
+                                 const CompressedTrack &track,
+                                 float animation_time, int &cursor) {
+    const PackedVec3 *keys = clip.vectors.data() + track.first_key;
+    if (track.key_count == 1)
+        return decodeCompressedVector(track, keys[0]);
+
+    float factor;
+    int key = findCompressedKey(clip.vector_times.data() + track.first_key,
+                                track.key_count, clip.time_step,
+                                animation_time, cursor, factor);
+    return interpolateKeys(decodeCompressedVector(track, keys[key]),
+                           decodeCompressedVector(track, keys[key + 1]),
+                           factor);
+}
+
+glm::quat sampleCompressedRotation(const CompressedClip &clip,
+                                   const CompressedTrack &track,
+                                   float animation_time, int &cursor) {
+    const PackedQuat *keys = clip.rotations.data() + track.first_key;
+    if (track.key_count == 1)
+        return unpackQuat(keys[0]);
+
+    float factor;
+    int key = findCompressedKey(clip.rotation_times.data() + track.first_key,
+                                track.key_count, clip.time_step,
+                                animation_time, cursor, factor);
+    return interpolateKeys(unpackQuat(keys[key]), unpackQuat(keys[key + 1]),
+                           factor);
+}
+
+size_t getCompressedClipBytes(const CompressedClip &clip) {
+    return clip.channels.size() * sizeof(CompressedChannel) +
+           clip.vector_times.size() * sizeof(uint16_t) +
+           clip.rotation_times.size() * sizeof(uint16_t) +
+           clip.vectors.size() * sizeof(PackedVec3) +
+           clip.rotations.size() * sizeof(PackedQuat);
+}
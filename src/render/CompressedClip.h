@@ -0,0 +1,86 @@
+#ifndef COMPRESSED_CLIP_H
+#define COMPRESSED_CLIP_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+// Compact copy of a clip's keyed tracks. At compression, keys that linear
+// interpolation (nlerp for rotations) between their neighbours reproduces
+// within a tolerance are dropped. The surviving keys are quantized:
+// - times to 16 bits over the clip's duration
+// - translations and scales to 16 bits per axis over the range of their own
+//   track
+// - rotations to 48 bits, smallest-three: the largest component of the unit
+//   quaternion is left out and rebuilt from the other three, which all lie
+//   in [-1/sqrt(2), 1/sqrt(2)] and get 15 bits each
+// A key costs 8 bytes, against 16 or 20 for KeyPosition/KeyRotation, and the
+// sampler decodes the two keys around the time on the fly.
+
+struct PackedVec3 {
+    uint16_t x, y, z;
+};
+
+// Rotation components are stored as 15 bits over [-PACKED_QUAT_RANGE,
+// PACKED_QUAT_RANGE]
+const float PACKED_QUAT_COMPONENT_MAX = 32767.0f;
+const float PACKED_QUAT_RANGE = 0.70710678f; // 1 / sqrt(2)
+
+struct PackedQuat {
+    uint16_t v[3]; // 15-bit components; the top bits of v[0], v[1] hold the
+                   // index of the dropped one
+};
+
+struct CompressedTrack {
+    uint32_t first_key = 0; // Into the clip's value array and its times
+    uint32_t key_count = 0;
+    glm::vec3 origin{0.0f}; // Vector tracks: value of quantized (0, 0, 0)
+    glm::vec3 step{0.0f};   // and the size of one quantization step
+};
+
+struct CompressedChannel {
+    CompressedTrack position; // Keys in CompressedClip::vectors
+    CompressedTrack rotation; // Keys in CompressedClip::rotations
+    CompressedTrack scale;    // Keys in CompressedClip::vectors too
+};
+
+struct CompressedClip {
+    std::vector<CompressedChannel> channels;
+    // Every track's keys, one run per track, each key's time at the same
+    // index as its value
+    std::vector<PackedVec3> vectors;
+    std::vector<uint16_t> vector_times;
+    std::vector<PackedQuat> rotations;
+    std::vector<uint16_t> rotation_times;
+    float time_step = 0.0f; // Ticks per quantized time unit
+};
+
+PackedQuat packQuat(glm::quat rotation);
+glm::quat unpackQuat(const PackedQuat &packed);
+
+// Starts an empty clip for keys in [0, duration] ticks
+CompressedClip createCompressedClip(float duration);
+// Reduce the keys of one track and append what's left to the clip.
+// tolerance is in the track's units, radians for rotations.
+CompressedTrack addCompressedVectorTrack(CompressedClip &clip,
+                                         const std::vector<float> &times,
+                                         const std::vector<glm::vec3> &values,
+                                         float tolerance);
+CompressedTrack addCompressedRotationTrack(CompressedClip &clip,
+                                           const std::vector<float> &times,
+                                           const std::vector<glm::quat> &values,
+                                           float tolerance);
+
+// Sample a track at animation_time, decoding only the two keys around it.
+// cursor works as in BoneAnimation::getPositionIndex.
+glm::vec3 sampleCompressedVector(const CompressedClip &clip,
+                                 const CompressedTrack &track,
+                                 float animation_time, int &cursor);
+glm::quat sampleCompressedRotation(const CompressedClip &clip,
+                                   const CompressedTrack &track,
+                                   float animation_time, int &cursor);
+
+size_t getCompressedClipBytes(const CompressedClip &clip);
+
+#endif
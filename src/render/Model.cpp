@@ -358,9 +358,21 @@ Model loadModel(const std::string &path) {
         return model;
     }
     model.directory = path.substr(0, path.find_last_of('/'));
+    model.source_path = path;
 
     glm::mat4 identity = glm::mat4(1.0f);
     processNode(scene->mRootNode, scene, identity, model);
+    if (!model.bone_info_map.empty()) {
+        model.skeleton = createSkeleton(scene->mRootNode, model.bone_info_map);
+    }
+
+    model.bounds = Collision::createEmptyAABB();
+    for (const Mesh &mesh : model.meshes) {
+        for (const Vertex &vertex : mesh.vertices) {
+            model.bounds.min = glm::min(model.bounds.min, vertex.position);
+            model.bounds.max = glm::max(model.bounds.max, vertex.position);
+        }
+    }
 
     return model;
 }
@@ -3,8 +3,10 @@
 
 #include "../math/GeometryUtils.h" // Vertex
 #include "ShaderProgram.h"
+#include "Skeleton.h" // For BoneInfo
 #include <glm/glm.hpp>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,12 +16,6 @@ struct Texture {
     std::string path;
 };
 
-// Helper struct for Animation
-struct BoneInfo {
-    int id;           // Index in the final bone matrices array
-    glm::mat4 offset; // Transforms from model space to bone space
-};
-
 struct Mesh {
     unsigned int vao;
     unsigned int vbo;
@@ -29,7 +25,8 @@ struct Mesh {
     std::vector<Texture> textures;
     glm::vec3 diffuse_color;
 
-    // Keeping raw data for debugging or CPU-side physics if needed
+    // Keeping raw data for debugging or CPU-side physics if needed; released
+    // for static objects once their collision mesh is built
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
 };
@@ -38,10 +35,15 @@ struct Model {
     std::vector<Mesh> meshes;
     std::vector<Texture> loaded_textures;
     std::string directory;
+    std::string source_path; // File it was loaded from; identifies shared meshes
+    Collision::AABB bounds; // Model space, over every mesh vertex
 
     // Animation Data
     std::map<std::string, BoneInfo> bone_info_map; // Maps bone name to info
     int bone_counter = 0; // Tracks number of bones found
+    // Built from the hierarchy once the bones are known; shared with every
+    // clip loaded for the model. Null if no mesh is skinned.
+    std::shared_ptr<const Skeleton> skeleton;
 };
 
 // Loads a model from a file path
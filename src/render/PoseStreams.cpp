@@ -0,0 +1,346 @@
+#include "PoseStreams.h"
+#include "CompressedClip.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define POSE_STREAMS_X86 1
+#include <emmintrin.h> // SSE2 is part of the x86-64 baseline
+#endif
+
+namespace {
+
+const uint32_t POSE_STREAM_WIDTH = 4; // Channels per lane group
+const float POSE_STREAM_VALUE_MAX = 65535.0f;
+
+enum PoseStreamComponent {
+    POSE_T_X, POSE_T_Y, POSE_T_Z,
+    POSE_Q_0, POSE_Q_1, POSE_Q_2, // PackedQuat::v
+    POSE_S_X, POSE_S_Y, POSE_S_Z
+};
+
+enum PoseRangeComponent {
+    POSE_T_ORIGIN = 0, POSE_T_STEP = 3,
+    POSE_S_ORIGIN = 6, POSE_S_STEP = 9
+};
+
+struct ScalarOps {
+    typedef float V;
+    typedef bool M;
+    static const int WIDTH = 1;
+
+    static V set1(float f) { return f; }
+    static V load(const float *p) { return *p; }
+    static V load(const uint16_t *p) { return *p; }
+    static void store(float *p, V v) { *p = v; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V max(V a, V b) { return std::max(a, b); }
+    static V sqrt(V a) { return std::sqrt(a); }
+    // a < 0 ? -b : b
+    static V flipIfNegative(V a, V b) { return a < 0.0f ? -b : b; }
+    static M greaterEqual(V a, V b) { return a >= b; }
+    static M equal(V a, V b) { return a == b; }
+    // m ? a : b
+    static V select(M m, V a, V b) { return m ? a : b; }
+};
+
+#ifdef POSE_STREAMS_X86
+struct SseOps {
+    typedef __m128 V;
+    typedef __m128 M;
+    static const int WIDTH = 4;
+
+    static V set1(float f) { return _mm_set1_ps(f); }
+    static V load(const float *p) { return _mm_loadu_ps(p); }
+    // Four 16-bit values, widened to floats
+    static V load(const uint16_t *p) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p));
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+    }
+    static void store(float *p, V v) { _mm_storeu_ps(p, v); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static V flipIfNegative(V a, V b) {
+        return _mm_xor_ps(b, _mm_and_ps(a, _mm_set1_ps(-0.0f)));
+    }
+    static M greaterEqual(V a, V b) { return _mm_cmpge_ps(a, b); }
+    static M equal(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    static V select(M m, V a, V b) {
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+};
+typedef SseOps PoseOps;
+#else
+typedef ScalarOps PoseOps;
+#endif
+
+// Rebuilds Ops::WIDTH quaternions (x, y, z, w) from their PackedQuat
+// components, as unpackQuat does one at a time. The values come in as
+// floats, which hold 16 bits exactly, so the index bits are split off by
+// comparison rather than integer masks.
+template <typename Ops>
+void unpackPoseRotations(const typename Ops::V packed[3],
+                         typename Ops::V q[4]) {
+    typedef typename Ops::V V;
+    typedef typename Ops::M M;
+    const V zero = Ops::set1(0.0f);
+    const V top_bit = Ops::set1(32768.0f);
+    const V scale = Ops::set1(2.0f * PACKED_QUAT_RANGE /
+                              PACKED_QUAT_COMPONENT_MAX);
+    const V bias = Ops::set1(-PACKED_QUAT_RANGE);
+
+    M high0 = Ops::greaterEqual(packed[0], top_bit);
+    M high1 = Ops::greaterEqual(packed[1], top_bit);
+    V c[3] = {Ops::sub(packed[0], Ops::select(high0, top_bit, zero)),
+              Ops::sub(packed[1], Ops::select(high1, top_bit, zero)),
+              packed[2]};
+    V sum = zero;
+    for (int i = 0; i < 3; ++i) {
+        c[i] = Ops::add(Ops::mul(c[i], scale), bias);
+        sum = Ops::add(sum, Ops::mul(c[i], c[i]));
+    }
+    V largest = Ops::sqrt(Ops::max(Ops::sub(Ops::set1(1.0f), sum), zero));
+
+    // Put the rebuilt component back in the dropped one's place
+    V index = Ops::add(Ops::select(high0, Ops::set1(2.0f), zero),
+                       Ops::select(high1, Ops::set1(1.0f), zero));
+    M is0 = Ops::equal(index, zero);
+    M is1 = Ops::equal(index, Ops::set1(1.0f));
+    M is2 = Ops::equal(index, Ops::set1(2.0f));
+    M is3 = Ops::equal(index, Ops::set1(3.0f));
+    q[0] = Ops::select(is0, largest, c[0]);
+    q[1] = Ops::select(is0, c[0], Ops::select(is1, largest, c[1]));
+    q[2] = Ops::select(is2, largest, Ops::select(is3, c[2], c[1]));
+    q[3] = Ops::select(is3, largest, c[2]);
+}
+
+// Samples channels [0, stride) between frames a and b, Ops::WIDTH at a time
+template <typename Ops>
+void samplePoseChannels(const uint16_t *a, const uint16_t *b,
+                        const float *ranges, uint32_t stride, float factor,
+                        float *out) {
+    typedef typename Ops::V V;
+    const V f = Ops::set1(factor);
+    const V one = Ops::set1(1.0f);
+    const V two = Ops::set1(2.0f);
+
+    for (uint32_t i = 0; i < stride; i += Ops::WIDTH) {
+        V from[POSE_STREAM_COMPONENTS];
+        V to[POSE_STREAM_COMPONENTS];
+        for (uint32_t c = 0; c < POSE_STREAM_COMPONENTS; ++c) {
+            from[c] = Ops::load(a + c * stride + i);
+            to[c] = Ops::load(b + c * stride + i);
+        }
+
+        // Translation and scale decode linearly, so lerp the quantized
+        // values and decode once
+        V translation[3];
+        V scale[3];
+        for (uint32_t c = 0; c < 3; ++c) {
+            V t = Ops::add(from[POSE_T_X + c],
+                           Ops::mul(Ops::sub(to[POSE_T_X + c],
+                                             from[POSE_T_X + c]),
+                                    f));
+            translation[c] = Ops::add(
+                Ops::load(ranges + (POSE_T_ORIGIN + c) * stride + i),
+                Ops::mul(t, Ops::load(ranges + (POSE_T_STEP + c) * stride +
+                                      i)));
+            V s = Ops::add(from[POSE_S_X + c],
+                           Ops::mul(Ops::sub(to[POSE_S_X + c],
+                                             from[POSE_S_X + c]),
+                                    f));
+            scale[c] = Ops::add(
+                Ops::load(ranges + (POSE_S_ORIGIN + c) * stride + i),
+                Ops::mul(s, Ops::load(ranges + (POSE_S_STEP + c) * stride +
+                                      i)));
+        }
+
+        V qa[4];
+        V qb[4];
+        unpackPoseRotations<Ops>(from + POSE_Q_0, qa);
+        unpackPoseRotations<Ops>(to + POSE_Q_0, qb);
+
+        // Take the rotation's shorter arc: flip b's quaternion when it
+        // points away from a's
+        V d = Ops::mul(qa[3], qb[3]);
+        for (uint32_t q = 0; q < 3; ++q) {
+            d = Ops::add(d, Ops::mul(qa[q], qb[q]));
+        }
+        V v[4];
+        for (uint32_t q = 0; q < 4; ++q) {
+            V target = Ops::flipIfNegative(d, qb[q]);
+            v[q] = Ops::add(qa[q], Ops::mul(Ops::sub(target, qa[q]), f));
+        }
+
+        // nlerp: renormalise the blended quaternion
+        V length_sq = Ops::add(Ops::add(Ops::mul(v[0], v[0]),
+                                        Ops::mul(v[1], v[1])),
+                               Ops::add(Ops::mul(v[2], v[2]),
+                                        Ops::mul(v[3], v[3])));
+        V inv_length = Ops::div(one, Ops::sqrt(length_sq));
+        V x = Ops::mul(v[0], inv_length);
+        V y = Ops::mul(v[1], inv_length);
+        V z = Ops::mul(v[2], inv_length);
+        V w = Ops::mul(v[3], inv_length);
+
+        // Rotation matrix of the quaternion (as glm::mat4_cast), with each
+        // column scaled by the channel's scale: T * R * S in one go
+        V xx = Ops::mul(x, x), yy = Ops::mul(y, y), zz = Ops::mul(z, z);
+        V xy = Ops::mul(x, y), xz = Ops::mul(x, z), yz = Ops::mul(y, z);
+        V wx = Ops::mul(w, x), wy = Ops::mul(w, y), wz = Ops::mul(w, z);
+        V rows[POSE_AFFINE_COMPONENTS] = {
+            Ops::sub(one, Ops::mul(two, Ops::add(yy, zz))),
+            Ops::mul(two, Ops::sub(xy, wz)),
+            Ops::mul(two, Ops::add(xz, wy)),
+            translation[0],
+            Ops::mul(two, Ops::add(xy, wz)),
+            Ops::sub(one, Ops::mul(two, Ops::add(xx, zz))),
+            Ops::mul(two, Ops::sub(yz, wx)),
+            translation[1],
+            Ops::mul(two, Ops::sub(xz, wy)),
+            Ops::mul(two, Ops::add(yz, wx)),
+            Ops::sub(one, Ops::mul(two, Ops::add(xx, yy))),
+            translation[2]};
+        for (uint32_t r = 0; r < 3; ++r) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                rows[r * 4 + c] = Ops::mul(rows[r * 4 + c], scale[c]);
+            }
+        }
+        for (uint32_t c = 0; c < POSE_AFFINE_COMPONENTS; ++c) {
+            Ops::store(out + c * stride + i, rows[c]);
+        }
+    }
+}
+
+uint16_t *getPoseStreamValue(PoseStreams &streams, uint32_t frame,
+                             uint32_t component, uint32_t channel) {
+    return streams.data.data() +
+           (static_cast<size_t>(frame) * POSE_STREAM_COMPONENTS + component) *
+               streams.stride +
+           channel;
+}
+
+// Quantizes a channel's vectors over their own range into stream components
+// [first, first + 3), and that range into ranges components origin and step
+void setPoseStreamVectors(PoseStreams &streams, uint32_t channel,
+                          const std::vector<glm::vec3> &values,
+                          uint32_t first, uint32_t origin, uint32_t step) {
+    glm::vec3 low = values[0];
+    glm::vec3 high = low;
+    for (const glm::vec3 &value : values) {
+        low = glm::min(low, value);
+        high = glm::max(high, value);
+    }
+    glm::vec3 size = (high - low) / POSE_STREAM_VALUE_MAX;
+    for (uint32_t c = 0; c < 3; ++c) {
+        streams.ranges[(origin + c) * streams.stride + channel] = low[c];
+        streams.ranges[(step + c) * streams.stride + channel] = size[c];
+    }
+
+    glm::vec3 inv_size(size.x > 0.0f ? 1.0f / size.x : 0.0f,
+                       size.y > 0.0f ? 1.0f / size.y : 0.0f,
+                       size.z > 0.0f ? 1.0f / size.z : 0.0f);
+    for (uint32_t frame = 0; frame < streams.frame_count; ++frame) {
+        glm::vec3 q = glm::floor((values[frame] - low) * inv_size + 0.5f);
+        q = glm::clamp(q, glm::vec3(0.0f), glm::vec3(POSE_STREAM_VALUE_MAX));
+        for (uint32_t c = 0; c < 3; ++c) {
+            *getPoseStreamValue(streams, frame, first + c, channel) =
+                static_cast<uint16_t>(q[c]);
+        }
+    }
+}
+
+} // namespace
+
+PoseStreams createPoseStreams(uint32_t channel_count, uint32_t frame_count,
+                              float frame_interval) {
+    PoseStreams streams;
+    streams.channel_count = channel_count;
+    streams.stride = (channel_count + POSE_STREAM_WIDTH - 1) /
+                     POSE_STREAM_WIDTH * POSE_STREAM_WIDTH;
+    streams.frame_count = frame_count;
+    streams.frame_interval = frame_interval;
+    streams.data.assign(static_cast<size_t>(frame_count) *
+                            POSE_STREAM_COMPONENTS * streams.stride,
+                        0);
+    streams.ranges.assign(POSE_RANGE_COMPONENTS * streams.stride, 0.0f);
+
+    // Translation and scale decode to their origins; padding lanes keep
+    // these identity channels so they sample to finite values
+    PackedQuat identity = packQuat(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    for (uint32_t i = 0; i < streams.stride; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            streams.ranges[(POSE_S_ORIGIN + c) * streams.stride + i] = 1.0f;
+        }
+        for (uint32_t frame = 0; frame < frame_count; ++frame) {
+            for (uint32_t q = 0; q < 3; ++q) {
+                *getPoseStreamValue(streams, frame, POSE_Q_0 + q, i) =
+                    identity.v[q];
+            }
+        }
+    }
+    return streams;
+}
+
+void setPoseStreamChannel(PoseStreams &streams, uint32_t channel,
+                          const std::vector<glm::vec3> &positions,
+                          const std::vector<glm::quat> &rotations,
+                          const std::vector<glm::vec3> &scales) {
+    if (streams.frame_count == 0)
+        return;
+
+    setPoseStreamVectors(streams, channel, positions, POSE_T_X, POSE_T_ORIGIN,
+                         POSE_T_STEP);
+    setPoseStreamVectors(streams, channel, scales, POSE_S_X, POSE_S_ORIGIN,
+                         POSE_S_STEP);
+    for (uint32_t frame = 0; frame < streams.frame_count; ++frame) {
+        PackedQuat packed = packQuat(rotations[frame]);
+        for (uint32_t q = 0; q < 3; ++q) {
+            *getPoseStreamValue(streams, frame, POSE_Q_0 + q, channel) =
+                packed.v[q];
+        }
+    }
+}
+
+void samplePoseStreams(const PoseStreams &streams, float animation_time,
+                       float *out) {
+    if (streams.frame_count == 0)
+        return;
+
+    float frame = std::max(animation_time / streams.frame_interval, 0.0f);
+    uint32_t last_frame = streams.frame_count - 1;
+    uint32_t frame_a = std::min(static_cast<uint32_t>(frame), last_frame);
+    uint32_t frame_b = std::min(frame_a + 1, last_frame);
+    float factor = std::min(frame - frame_a, 1.0f);
+
+    size_t frame_size =
+        static_cast<size_t>(POSE_STREAM_COMPONENTS) * streams.stride;
+    samplePoseChannels<PoseOps>(streams.data.data() + frame_a * frame_size,
+                                streams.data.data() + frame_b * frame_size,
+                                streams.ranges.data(), streams.stride, factor,
+                                out);
+}
+
+glm::mat4 getPoseAffine(const float *affine, uint32_t stride,
+                        uint32_t channel) {
+    const float *p = affine + channel;
+    glm::mat4 m(1.0f);
+    for (uint32_t r = 0; r < 3; ++r) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            m[c][r] = p[(r * 4 + c) * stride]; // glm is column-major
+        }
+    }
+    return m;
+}
+
+size_t getPoseStreamsBytes(const PoseStreams &streams) {
+    return streams.data.size() * sizeof(uint16_t) +
+           streams.ranges.size() * sizeof(float);
+}
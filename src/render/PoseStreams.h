@@ -0,0 +1,60 @@
+#ifndef POSE_STREAMS_H
+#define POSE_STREAMS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+// 16-bit values stored per channel and frame: translation xyz, rotation as
+// its smallest three components (as PackedQuat), scale xyz
+const uint32_t POSE_STREAM_COMPONENTS = 9;
+// Floats per channel to decode them: translation origin xyz and step xyz,
+// then scale origin xyz and step xyz
+const uint32_t POSE_RANGE_COMPONENTS = 12;
+// Floats per sampled channel: the three rows of an affine 3x4 matrix
+const uint32_t POSE_AFFINE_COMPONENTS = 12;
+
+// A clip's channels resampled onto one uniform time grid and stored frame by
+// frame as structure-of-arrays. Component c of channel i at frame k lives at
+// data[(k * POSE_STREAM_COMPONENTS + c) * stride + i], so sampling reads
+// every channel's translation x, then every channel's translation y, and so
+// on, 4 channels per SIMD lane group. The stride is padded to a whole group.
+// Values are quantized like CompressedClip's keys: translation and scale to
+// 16 bits per axis over the channel's own range (kept per channel in
+// `ranges`), rotations to 48 bits smallest-three. A frame costs 18 bytes per
+// channel, and the sampler decodes in the same SIMD pass that interpolates.
+struct PoseStreams {
+    std::vector<uint16_t> data;
+    // Component r of channel i at ranges[r * stride + i]
+    std::vector<float> ranges;
+    uint32_t channel_count = 0;
+    uint32_t stride = 0;
+    uint32_t frame_count = 0;
+    float frame_interval = 0.0f; // Ticks between frames
+};
+
+// Storage for frame_count frames of channel_count identity channels
+PoseStreams createPoseStreams(uint32_t channel_count, uint32_t frame_count,
+                              float frame_interval);
+// Quantizes every frame of one channel; each vector holds frame_count values
+void setPoseStreamChannel(PoseStreams &streams, uint32_t channel,
+                          const std::vector<glm::vec3> &positions,
+                          const std::vector<glm::quat> &rotations,
+                          const std::vector<glm::vec3> &scales);
+
+// Samples every channel at animation_time (clamped to the grid): lerped
+// translation and scale, nlerped rotation along the shorter arc, composed
+// straight into translation * rotation * scale as an affine 3x4. Row r,
+// column c of channel i goes to out[(r * 4 + c) * stride + i]; out holds
+// POSE_AFFINE_COMPONENTS * stride floats.
+void samplePoseStreams(const PoseStreams &streams, float animation_time,
+                       float *out);
+
+// One channel of samplePoseStreams' output as a mat4
+glm::mat4 getPoseAffine(const float *affine, uint32_t stride,
+                        uint32_t channel);
+
+size_t getPoseStreamsBytes(const PoseStreams &streams);
+
+#endif
@@ -2,6 +2,7 @@
 #include "Renderer.h"
 #include "../config.h"
 #include "../math/GeometryUtils.h"
+#include "../scene/Scene.h"
 #include <glad/gl.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <string> // For std::to_string
@@ -44,10 +45,8 @@ void renderScene(GLFWwindow *window, GameState &state,
     // support! For now, shadows might look static/T-pose unless we update depth
     // shader too.
     for (const auto &object : state.scene_objects) {
-        glm::mat4 model_matrix = glm::mat4(1.0f);
-        model_matrix = glm::translate(model_matrix, object.position);
-        model_matrix = model_matrix * glm::mat4_cast(object.orientation);
-        model_matrix = glm::scale(model_matrix, object.scale);
+        glm::mat4 model_matrix =
+            getSceneObjectRenderMatrix(object, state.interpolation_alpha);
         setShaderMat4(depth_shader_program, "model", model_matrix);
 
         // Quick hack: Pass identity matrices to depth shader if it has bone
@@ -99,10 +98,8 @@ void renderScene(GLFWwindow *window, GameState &state,
 
     // Draw scene objects
     for (const auto &object : state.scene_objects) {
-        glm::mat4 model_matrix = glm::mat4(1.0f);
-        model_matrix = glm::translate(model_matrix, object.position);
-        model_matrix = model_matrix * glm::mat4_cast(object.orientation);
-        model_matrix = glm::scale(model_matrix, object.scale);
+        glm::mat4 model_matrix =
+            getSceneObjectRenderMatrix(object, state.interpolation_alpha);
         setShaderMat4(shader_program, "model", model_matrix);
 
         glm::mat3 norm_mat = MathUtils::calculateNormalMatrix(model_matrix);
@@ -0,0 +1,61 @@
+#include "Skeleton.h"
+#include <assimp/scene.h>
+
+// Helpers for Assimp -> GLM conversion
+static glm::mat4 castMatrix(const aiMatrix4x4 &from) {
+    glm::mat4 to;
+    to[0][0] = from.a1;
+    to[1][0] = from.a2;
+    to[2][0] = from.a3;
+    to[3][0] = from.a4;
+    to[0][1] = from.b1;
+    to[1][1] = from.b2;
+    to[2][1] = from.b3;
+    to[3][1] = from.b4;
+    to[0][2] = from.c1;
+    to[1][2] = from.c2;
+    to[2][2] = from.c3;
+    to[3][2] = from.c4;
+    to[0][3] = from.d1;
+    to[1][3] = from.d2;
+    to[2][3] = from.d3;
+    to[3][3] = from.d4;
+    return to;
+}
+
+// Appends src and its subtree to skeleton.joints, parents first
+void readHeirarchyData(Skeleton &skeleton, const aiNode *src, int parent,
+                       const std::map<std::string, BoneInfo> &bone_info_map) {
+    std::string name = src->mName.data;
+
+    SkeletonJoint joint;
+    joint.transformation = castMatrix(src->mTransformation);
+    joint.parent = parent;
+    auto bone_info = bone_info_map.find(name);
+    joint.bone = bone_info == bone_info_map.end() ? -1 : bone_info->second.id;
+    joint.offset = bone_info == bone_info_map.end() ? glm::mat4(1.0f)
+                                                    : bone_info->second.offset;
+
+    int index = static_cast<int>(skeleton.joints.size());
+    skeleton.joints.push_back(joint);
+    skeleton.joint_names.push_back(name);
+    for (int i = 0; i < src->mNumChildren; i++) {
+        readHeirarchyData(skeleton, src->mChildren[i], index, bone_info_map);
+    }
+}
+
+std::shared_ptr<const Skeleton>
+createSkeleton(const aiNode *root,
+               const std::map<std::string, BoneInfo> &bone_info_map) {
+    auto skeleton = std::make_shared<Skeleton>();
+    readHeirarchyData(*skeleton, root, -1, bone_info_map);
+    return skeleton;
+}
+
+int findSkeletonJoint(const Skeleton &skeleton, const std::string &name) {
+    for (int i = 0; i < skeleton.joint_names.size(); i++) {
+        if (skeleton.joint_names[i] == name)
+            return i;
+    }
+    return -1;
+}
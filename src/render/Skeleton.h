@@ -0,0 +1,43 @@
+#ifndef SKELETON_H
+#define SKELETON_H
+
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct aiNode;
+
+// Helper struct for Animation
+struct BoneInfo {
+    int id;           // Index in the final bone matrices array
+    glm::mat4 offset; // Transforms from model space to bone space
+};
+
+// One node of the skeleton's hierarchy (mirroring Assimp's node structure),
+// with its bone resolved by name once at load
+struct SkeletonJoint {
+    glm::mat4 transformation; // Local transform when no channel animates it
+    int parent;               // Index in Skeleton::joints, -1 for the root
+    int bone;                 // Index in final_bone_matrices, -1 if no bone
+    glm::mat4 offset;         // The bone's offset, when there is one
+};
+
+// A model's node hierarchy, built once when the model loads and then only
+// read: the model and every clip loaded for it share one through a
+// shared_ptr<const Skeleton>.
+struct Skeleton {
+    // Flattened depth-first, so every parent comes before its children and
+    // one pass in order evaluates the whole pose
+    std::vector<SkeletonJoint> joints;
+    std::vector<std::string> joint_names; // Per joint; for binding clips
+};
+
+std::shared_ptr<const Skeleton>
+createSkeleton(const aiNode *root,
+               const std::map<std::string, BoneInfo> &bone_info_map);
+// Index of the joint for the named node, -1 if there is none
+int findSkeletonJoint(const Skeleton &skeleton, const std::string &name);
+
+#endif
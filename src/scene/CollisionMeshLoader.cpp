@@ -0,0 +1,75 @@
+#include "CollisionMeshLoader.h"
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <glm/glm.hpp>
+#include <iostream>
+
+static glm::mat4 castMatrix(const aiMatrix4x4 &from) {
+    glm::mat4 to;
+    to[0][0] = from.a1;
+    to[1][0] = from.a2;
+    to[2][0] = from.a3;
+    to[3][0] = from.a4;
+    to[0][1] = from.b1;
+    to[1][1] = from.b2;
+    to[2][1] = from.b3;
+    to[3][1] = from.b4;
+    to[0][2] = from.c1;
+    to[1][2] = from.c2;
+    to[2][2] = from.c3;
+    to[3][2] = from.c4;
+    to[0][3] = from.d1;
+    to[1][3] = from.d2;
+    to[2][3] = from.d3;
+    to[3][3] = from.d4;
+    return to;
+}
+
+static void collectNodeTriangles(const aiNode *node, const aiScene *scene,
+                                 glm::mat4 parent_transform,
+                                 std::vector<Collision::Triangle> &triangles) {
+    glm::mat4 global_transform =
+        parent_transform * castMatrix(node->mTransformation);
+
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        const aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
+        // Skinned meshes stay in bind space in loadModel; do the same here
+        glm::mat4 transform =
+            mesh->mNumBones > 0 ? glm::mat4(1.0f) : global_transform;
+
+        for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+            const aiFace &face = mesh->mFaces[f];
+            if (face.mNumIndices != 3)
+                continue; // Points/lines left over after triangulation
+
+            glm::vec3 corners[3];
+            for (int c = 0; c < 3; c++) {
+                const aiVector3D &v = mesh->mVertices[face.mIndices[c]];
+                corners[c] = glm::vec3(transform * glm::vec4(v.x, v.y, v.z, 1.0f));
+            }
+            triangles.push_back({corners[0], corners[1], corners[2]});
+        }
+    }
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        collectNodeTriangles(node->mChildren[i], scene, global_transform,
+                             triangles);
+    }
+}
+
+std::vector<Collision::Triangle> loadCollisionTriangles(const std::string &path) {
+    std::vector<Collision::Triangle> triangles;
+
+    Assimp::Importer importer;
+    const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
+        !scene->mRootNode) {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString()
+                  << std::endl;
+        return triangles;
+    }
+
+    collectNodeTriangles(scene->mRootNode, scene, glm::mat4(1.0f), triangles);
+    return triangles;
+}
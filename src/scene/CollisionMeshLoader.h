@@ -0,0 +1,14 @@
+#ifndef COLLISION_MESH_LOADER_H
+#define COLLISION_MESH_LOADER_H
+
+#include "../math/Octree.h" // For Collision::Triangle
+#include <string>
+#include <vector>
+
+// Loads the triangles of a model file for collision only: no GL buffers, no
+// textures, so it works without a window or GL context (tools, benchmarks).
+// Node transforms are baked in the same way loadModel bakes static meshes, so
+// the triangle list matches the one the engine builds from a loaded Model.
+std::vector<Collision::Triangle> loadCollisionTriangles(const std::string &path);
+
+#endif
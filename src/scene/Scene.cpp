@@ -2,6 +2,7 @@
 #include "../config.h"       // For Config constants
 #include "../render/Model.h" // For Model struct and loadModel function
 #include <glm/glm.hpp>       // For glm::vec3
+#include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 
 void loadScene(GameState &state) {
@@ -15,6 +16,7 @@ void loadScene(GameState &state) {
                   0.0f), // Orientation (Identity / No rotation)
         glm::vec3(1.0f)  // Scale
     });
+    state.scene_objects.back().is_static = true; // Level geometry
 
     // --- Load Player (New GLB Model) ---
     // GLB files often have embedded textures, which our new Model.cpp handles
@@ -41,3 +43,39 @@ void loadScene(GameState &state) {
     state.player_object_index =
         static_cast<int>(state.scene_objects.size() - 1);
 }
+
+glm::mat4 getSceneObjectMatrix(const SceneObject &object) {
+    glm::mat4 model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix, object.position);
+    model_matrix = model_matrix * glm::mat4_cast(object.orientation);
+    model_matrix = glm::scale(model_matrix, object.scale);
+    return model_matrix;
+}
+
+glm::vec3 getSceneObjectRenderPosition(const SceneObject &object, float alpha) {
+    return glm::mix(object.previous_position, object.position, alpha);
+}
+
+glm::mat4 getSceneObjectRenderMatrix(const SceneObject &object, float alpha) {
+    glm::mat4 model_matrix = glm::mat4(1.0f);
+    model_matrix = glm::translate(model_matrix,
+                                  getSceneObjectRenderPosition(object, alpha));
+    glm::quat orientation =
+        glm::slerp(object.previous_orientation, object.orientation, alpha);
+    model_matrix = model_matrix * glm::mat4_cast(orientation);
+    model_matrix = glm::scale(model_matrix, object.scale);
+    return model_matrix;
+}
+
+void savePreviousTransforms(GameState &state) {
+    for (SceneObject &object : state.scene_objects) {
+        object.previous_position = object.position;
+        object.previous_orientation = object.orientation;
+    }
+    state.camera.previous_position = state.camera.position;
+}
+
+Collision::AABB getSceneObjectBounds(const SceneObject &object) {
+    return Collision::transformAABB(object.model.bounds,
+                                    getSceneObjectMatrix(object));
+}
@@ -6,4 +6,16 @@
 
 void loadScene(GameState& state);
 
+// Simulated transform (latest tick)
+glm::mat4 getSceneObjectMatrix(const SceneObject& object);
+// Transform the renderer draws the object with: `alpha` of the way from the
+// previous tick's transform to the latest one
+glm::vec3 getSceneObjectRenderPosition(const SceneObject& object, float alpha);
+glm::mat4 getSceneObjectRenderMatrix(const SceneObject& object, float alpha);
+// Snapshots every object's (and the free camera's) transform as the
+// previous tick's, before a tick moves them
+void savePreviousTransforms(GameState& state);
+// World-space box around the object's model
+Collision::AABB getSceneObjectBounds(const SceneObject& object);
+
 #endif
@@ -1,6 +1,9 @@
 #ifndef SCENE_OBJECT_H
 #define SCENE_OBJECT_H
 
+#include "math/Broadphase.h"
+#include "math/CollisionScene.h"
+#include "math/ContactCache.h"
 #include "render/Model.h"
 #include <glm/glm.hpp>
 #include <string>
@@ -15,6 +18,19 @@ struct SceneObject {
     glm::vec3 scale;
     float y_velocity = 0.0f; // For gravity and jumping
     bool is_grounded = false; // To track if the object is on the ground
+    // Static objects collide through Engine::collision_scene, everything
+    // else through Engine::broadphase; each holds a handle in one of them
+    bool is_static = false;
+    // Static object moved by code (platform, door): its collision instance
+    // follows it every frame
+    bool is_kinematic = false;
+    uint32_t broadphase_proxy = Collision::BROADPHASE_NULL_PROXY;
+    uint32_t collision_instance = Collision::COLLISION_NULL_INSTANCE;
+    // Static geometry last found around the object, for its own queries
+    Collision::ContactCache contact_cache;
+    // Transform at the start of the latest simulation tick, for interpolation
+    glm::vec3 previous_position{0.0f};
+    glm::quat previous_orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 };
 
 #endif
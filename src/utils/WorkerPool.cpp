@@ -0,0 +1,83 @@
+#include "WorkerPool.h"
+#include <algorithm>
+
+// Pulls chunks of the current job until none are left
+void runWorkerPoolChunks(WorkerPool& pool) {
+    for (;;) {
+        size_t begin = pool.next_index.fetch_add(pool.job_grain);
+        if (begin >= pool.job_count) return;
+        (*pool.job)(begin, std::min(begin + pool.job_grain, pool.job_count));
+    }
+}
+
+void runWorkerPoolThread(WorkerPool* pool) {
+    uint64_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->job_ready.wait(lock, [&] { return pool->stopping || pool->generation != seen_generation; });
+            if (pool->stopping) return;
+            seen_generation = pool->generation;
+        }
+
+        runWorkerPoolChunks(*pool);
+
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (--pool->busy_workers == 0) pool->job_done.notify_one();
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+std::unique_ptr<WorkerPool> createWorkerPool(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    std::unique_ptr<WorkerPool> pool(new WorkerPool());
+    // The caller works too, so it needs one thread fewer
+    for (int i = 1; i < thread_count; ++i) {
+        pool->threads.emplace_back(runWorkerPoolThread, pool.get());
+    }
+    return pool;
+}
+
+int getWorkerPoolThreadCount(const WorkerPool& pool) {
+    return static_cast<int>(pool.threads.size()) + 1;
+}
+
+void parallelFor(WorkerPool& pool, size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(1, grain);
+    if (pool.threads.empty() || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.job = &fn;
+        pool.job_count = count;
+        pool.job_grain = grain;
+        pool.next_index = 0;
+        pool.busy_workers = static_cast<int>(pool.threads.size());
+        ++pool.generation;
+    }
+    pool.job_ready.notify_all();
+
+    runWorkerPoolChunks(pool);
+
+    // Every worker must check in (even with nothing left to take) before the
+    // job, which lives on this stack frame, can go away
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.job_done.wait(lock, [&] { return pool.busy_workers == 0; });
+    pool.job = nullptr;
+}
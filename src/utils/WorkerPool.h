@@ -0,0 +1,43 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads that split index ranges with the calling thread, so
+// per-frame batches don't pay for thread creation. Runs one job at a time.
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+
+    // Current job, valid while busy_workers > 0
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t job_count = 0;
+    size_t job_grain = 1;
+    std::atomic<size_t> next_index{0};
+    uint64_t generation = 0; // Bumped per job so workers can tell a new one apart
+    int busy_workers = 0;    // Workers that haven't finished the current job
+    bool stopping = false;
+
+    ~WorkerPool(); // Joins the threads
+};
+
+// thread_count counts the caller too; <= 0 uses every hardware thread
+std::unique_ptr<WorkerPool> createWorkerPool(int thread_count = 0);
+int getWorkerPoolThreadCount(const WorkerPool& pool);
+
+// Calls fn(begin, end) for chunks of at most `grain` indices covering
+// [0, count), on the workers and the calling thread. Returns when every
+// chunk has run. Chunk order and thread assignment are unspecified.
+void parallelFor(WorkerPool& pool, size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+#endif